@@ -0,0 +1,52 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define BLOCK_HEADER_SIZE ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+void arenaInit(Arena* arena, size_t blockSize) {
+    arena->head = NULL;
+    arena->blockSize = blockSize;
+}
+
+// Return size zeroed bytes, aligned for any type, or NULL if memory runs out
+void* arenaAlloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    ArenaBlock* block = arena->head;
+
+    if (block == NULL || block->capacity - block->used < size) {
+        // Oversized requests get a block of their own
+        size_t capacity = size > arena->blockSize ? size : arena->blockSize;
+
+        block = malloc(BLOCK_HEADER_SIZE + capacity);
+
+        if (block == NULL)
+            return NULL;
+
+        block->next = arena->head;
+        block->used = 0;
+        block->capacity = capacity;
+        arena->head = block;
+    }
+
+    char* memory = (char*)block + BLOCK_HEADER_SIZE + block->used;
+
+    block->used += size;
+    memset(memory, 0, size);
+
+    return memory;
+}
+
+void arenaFree(Arena* arena) {
+    ArenaBlock* block = arena->head;
+
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+
+        free(block);
+        block = next;
+    }
+
+    arena->head = NULL;
+}
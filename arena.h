@@ -0,0 +1,25 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t capacity;
+} ArenaBlock;
+
+/* Bump allocator for memory that lives exactly as long as its owner.
+   Nothing is freed on its own, arenaFree releases every block at once */
+typedef struct {
+    ArenaBlock* head;
+    size_t blockSize;
+} Arena;
+
+void arenaInit(Arena* arena, size_t blockSize);
+void* arenaAlloc(Arena* arena, size_t size);
+void arenaFree(Arena* arena);
+
+#endif
@@ -1,7 +1,7 @@
 #include <stdlib.h>
 #include "bst.h"
 
-BST* createBST(int (*compare)(void*, void*), void (*print)(void*), void (*freeData)(void*)) {
+BST* createBST(int (*compare)(void*, void*), void (*print)(void*)) {
     BST* binarySearchTree = malloc(sizeof(BST));
 
     if (binarySearchTree == NULL)
@@ -10,7 +10,6 @@ BST* createBST(int (*compare)(void*, void*), void (*print)(void*), void (*freeDa
     binarySearchTree->root = NULL;
     binarySearchTree->compare = compare;
     binarySearchTree->print = print;
-    binarySearchTree->freeData = freeData;
 
     return binarySearchTree;
 }
@@ -26,6 +25,7 @@ BSTNode* bstInsert(BSTNode* root, void* data, int (*compare)(void*, void*)) {
         root->left = NULL;
         root->right = NULL;
         root->data = data;
+        root->refCount = 1;
 
         return root;
     }
@@ -86,22 +86,88 @@ void bstPostorder(BSTNode* root, void (*print)(void*)) {
     print(root->data);
 }
 
-void bstFree(BSTNode* root, void (*freeData)(void*)) {
-    if (root == NULL) {
+void destroyBST(BST* binarySearchTree) {
+    if (binarySearchTree == NULL) {
         return;
     }
 
-    bstFree(root->left, freeData);
-    bstFree(root->right, freeData);
-    freeData(root->data);
-    free(root);
-};
+    bstRelease(binarySearchTree->root);
+    free(binarySearchTree);
+}
 
-void destroyBST(BST* binarySearchTree) {
-    if (binarySearchTree == NULL) {
+// Return a new reference to the same version of the tree in O(1)
+BSTNode* bstSnapshot(BSTNode* root) {
+    if (root != NULL) {
+        root->refCount++;
+    }
+
+    return root;
+}
+
+/* Copy a shared node for the caller, moving the caller's reference from the
+   original to the copy. Both nodes point to the same data */
+static BSTNode* copyNode(BSTNode* node) {
+    BSTNode* copy = malloc(sizeof(BSTNode));
+
+    if (copy == NULL) {
+        return NULL;
+    }
+
+    copy->data = node->data;
+    copy->left = node->left;
+    copy->right = node->right;
+    copy->refCount = 1;
+
+    if (copy->left != NULL)
+        copy->left->refCount++;
+
+    if (copy->right != NULL)
+        copy->right->refCount++;
+
+    node->refCount--;
+
+    return copy;
+}
+
+/* Insert into the version referenced by root, consuming that reference and
+   returning the new version. Nodes owned only by this version are updated in
+   place, shared nodes on the search path are copied, so other snapshots stay
+   unchanged and an insert copies at most O(depth) nodes */
+BSTNode* bstCowInsert(BSTNode* root, void* data, int (*compare)(void*, void*)) {
+    if (root == NULL) {
+        return bstInsert(NULL, data, compare);
+    }
+
+    if (root->refCount > 1) {
+        BSTNode* copy = copyNode(root);
+
+        if (copy == NULL) {
+            return root;
+        }
+
+        root = copy;
+    }
+
+    if (compare(data, root->data) < 0) {
+        root->left = bstCowInsert(root->left, data, compare);
+    } else {
+        root->right = bstCowInsert(root->right, data, compare);
+    }
+
+    return root;
+}
+
+// Drop one reference to a version, freeing the nodes no other version uses
+void bstRelease(BSTNode* root) {
+    if (root == NULL) {
         return;
     }
 
-    bstFree(binarySearchTree->root, binarySearchTree->freeData);
-    free(binarySearchTree);
+    if (--root->refCount > 0) {
+        return;
+    }
+
+    bstRelease(root->left);
+    bstRelease(root->right);
+    free(root);
 }
\ No newline at end of file
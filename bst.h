@@ -5,22 +5,27 @@ typedef struct BSTNode {
     void* data;
     struct BSTNode* left;
     struct BSTNode* right;
+    int refCount;
 } BSTNode;
 
 typedef struct {
     BSTNode* root;
     int (*compare)(void*, void*);
     void (*print)(void*);
-    void (*freeData)(void*);
 } BST;
 
-BST* createBST(int (*cmp)(void*, void*), void (*print)(void*), void (*freeData)(void*));
+BST* createBST(int (*cmp)(void*, void*), void (*print)(void*));
 BSTNode* bstInsert(BSTNode* root, void* data, int (*cmp)(void*, void*));
 void* bstFind(BSTNode* root, void* data, int (*cmp)(void*, void*));
 void bstInorder(BSTNode* root, void (*print)(void*));
 void bstPreorder(BSTNode* root, void (*print)(void*));
 void bstPostorder(BSTNode* root, void (*print)(void*));
-void bstFree(BSTNode* root, void (*freeData)(void*));
 void destroyBST(BST* binarySearchTree);
 
+/* Persistent (copy-on-write) mode: roots are counted references to shared
+   nodes. Trees never own their data, versions share it freely */
+BSTNode* bstSnapshot(BSTNode* root);
+BSTNode* bstCowInsert(BSTNode* root, void* data, int (*cmp)(void*, void*));
+void bstRelease(BSTNode* root);
+
 #endif
@@ -0,0 +1,360 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "combat.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define COMBAT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#define INITIAL_BATCH_CAPACITY 16
+
+typedef void (*CombatKernel)(const int* hp, const int* attack, int count, int baseAttack, int maxHp,
+     int* rounds, int* damageTaken, unsigned char* won);
+
+MonsterBatch* createMonsterBatch(int capacity) {
+    MonsterBatch* batch = malloc(sizeof(MonsterBatch));
+
+    if (batch == NULL)
+        return NULL;
+
+    if (capacity < INITIAL_BATCH_CAPACITY)
+        capacity = INITIAL_BATCH_CAPACITY;
+
+    batch->hp = malloc(capacity * sizeof(int));
+    batch->attack = malloc(capacity * sizeof(int));
+    batch->count = 0;
+    batch->capacity = capacity;
+
+    if (batch->hp == NULL || batch->attack == NULL) {
+        destroyMonsterBatch(batch);
+
+        return NULL;
+    }
+
+    return batch;
+}
+
+// Return the index of the added monster, or -1 on allocation failure
+int monsterBatchAdd(MonsterBatch* batch, int hp, int attack) {
+    if (batch->count == batch->capacity) {
+        int capacity = batch->capacity * 2;
+        int* newHp = realloc(batch->hp, capacity * sizeof(int));
+
+        if (newHp == NULL)
+            return -1;
+
+        batch->hp = newHp;
+
+        int* newAttack = realloc(batch->attack, capacity * sizeof(int));
+
+        if (newAttack == NULL)
+            return -1;
+
+        batch->attack = newAttack;
+        batch->capacity = capacity;
+    }
+
+    batch->hp[batch->count] = hp;
+    batch->attack[batch->count] = attack;
+
+    return batch->count++;
+}
+
+MonsterBatch* collectMonsters(GameState* gameState) {
+    MonsterBatch* batch = createMonsterBatch(gameState->roomCount);
+
+    if (batch == NULL)
+        return NULL;
+
+    for (int id = 0; id < gameState->roomCount; id++) {
+        Monster* monster = roomMonster(gameState, roomAt(gameState, id));
+
+        if (monster == NULL)
+            continue;
+
+        if (monsterBatchAdd(batch, monster->hp, monster->attack) < 0) {
+            destroyMonsterBatch(batch);
+
+            return NULL;
+        }
+    }
+
+    return batch;
+}
+
+void destroyMonsterBatch(MonsterBatch* batch) {
+    if (batch == NULL)
+        return;
+
+    free(batch->hp);
+    free(batch->attack);
+    free(batch);
+}
+
+CombatOutcomes* createCombatOutcomes(int count) {
+    CombatOutcomes* outcomes = malloc(sizeof(CombatOutcomes));
+
+    if (outcomes == NULL)
+        return NULL;
+
+    if (count < 1)
+        count = 1;
+
+    outcomes->rounds = malloc(count * sizeof(int));
+    outcomes->damageTaken = malloc(count * sizeof(int));
+    outcomes->won = malloc(count * sizeof(unsigned char));
+
+    if (outcomes->rounds == NULL || outcomes->damageTaken == NULL || outcomes->won == NULL) {
+        destroyCombatOutcomes(outcomes);
+
+        return NULL;
+    }
+
+    return outcomes;
+}
+
+void destroyCombatOutcomes(CombatOutcomes* outcomes) {
+    if (outcomes == NULL)
+        return;
+
+    free(outcomes->rounds);
+    free(outcomes->damageTaken);
+    free(outcomes->won);
+    free(outcomes);
+}
+
+/* Closed form of the loop in fight(): the player needs ceil(hp / baseAttack) hits
+   and takes one monster hit less than that, unless ceil(maxHp / attack) monster
+   hits land first. A monster with non-positive attack is treated as harmless.
+   Losing fights report the whole maxHp as damage, as fight() clamps hp to 0 */
+static void resolveScalar(const int* hp, const int* attack, int count, int baseAttack, int maxHp,
+     int* rounds, int* damageTaken, unsigned char* won) {
+    for (int i = 0; i < count; i++) {
+        int monsterHp = hp[i] > 0 ? hp[i] : 0;
+        int monsterAttack = attack[i] > 0 ? attack[i] : 0;
+        int divisor = monsterAttack > 0 ? monsterAttack : 1;
+
+        int hitsToKill = monsterHp / baseAttack + (monsterHp % baseAttack != 0);
+        int hitsTaken = hitsToKill > 0 ? hitsToKill - 1 : 0;
+        int hitsToDie = maxHp / divisor + (maxHp % divisor != 0);
+        int playerWins = monsterAttack == 0 || hitsTaken < hitsToDie;
+
+        rounds[i] = playerWins ? hitsToKill : hitsToDie;
+        damageTaken[i] = playerWins ? hitsTaken * monsterAttack : maxHp;
+        won[i] = (unsigned char)playerWins;
+    }
+}
+
+#ifdef COMBAT_X86_KERNELS
+
+/* The SIMD kernels divide in double precision: every int32 quotient is exact
+   there, and truncate-then-correct gives the ceiling without SSE4.1 rounding */
+__attribute__((target("sse2")))
+static inline void resolvePairSse2(__m128d monsterHp, __m128d monsterAttack, __m128d baseAttack,
+     __m128d maxHp, int* rounds, int* damageTaken, unsigned char* won) {
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+
+    monsterHp = _mm_max_pd(monsterHp, zero);
+    monsterAttack = _mm_max_pd(monsterAttack, zero);
+    __m128d divisor = _mm_max_pd(monsterAttack, one);
+
+    __m128d hitsToKill = _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_div_pd(monsterHp, baseAttack)));
+    hitsToKill = _mm_add_pd(hitsToKill, _mm_and_pd(_mm_cmplt_pd(_mm_mul_pd(hitsToKill, baseAttack), monsterHp), one));
+    __m128d hitsTaken = _mm_max_pd(_mm_sub_pd(hitsToKill, one), zero);
+
+    __m128d hitsToDie = _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_div_pd(maxHp, divisor)));
+    hitsToDie = _mm_add_pd(hitsToDie, _mm_and_pd(_mm_cmplt_pd(_mm_mul_pd(hitsToDie, divisor), maxHp), one));
+
+    __m128d playerWins = _mm_or_pd(_mm_cmpeq_pd(monsterAttack, zero), _mm_cmplt_pd(hitsTaken, hitsToDie));
+    __m128d roundCount = _mm_or_pd(_mm_and_pd(playerWins, hitsToKill), _mm_andnot_pd(playerWins, hitsToDie));
+    __m128d damage = _mm_or_pd(_mm_and_pd(playerWins, _mm_mul_pd(hitsTaken, monsterAttack)),
+         _mm_andnot_pd(playerWins, maxHp));
+
+    _mm_storel_epi64((__m128i*)rounds, _mm_cvttpd_epi32(roundCount));
+    _mm_storel_epi64((__m128i*)damageTaken, _mm_cvttpd_epi32(damage));
+
+    int mask = _mm_movemask_pd(playerWins);
+    won[0] = (unsigned char)(mask & 1);
+    won[1] = (unsigned char)((mask >> 1) & 1);
+}
+
+__attribute__((target("sse2")))
+static void resolveSse2(const int* hp, const int* attack, int count, int baseAttack, int maxHp,
+     int* rounds, int* damageTaken, unsigned char* won) {
+    const __m128d baseAttackVector = _mm_set1_pd(baseAttack);
+    const __m128d maxHpVector = _mm_set1_pd(maxHp);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i hpLanes = _mm_loadu_si128((const __m128i*)(hp + i));
+        __m128i attackLanes = _mm_loadu_si128((const __m128i*)(attack + i));
+
+        resolvePairSse2(_mm_cvtepi32_pd(hpLanes), _mm_cvtepi32_pd(attackLanes), baseAttackVector,
+             maxHpVector, rounds + i, damageTaken + i, won + i);
+        resolvePairSse2(_mm_cvtepi32_pd(_mm_srli_si128(hpLanes, 8)), _mm_cvtepi32_pd(_mm_srli_si128(attackLanes, 8)),
+             baseAttackVector, maxHpVector, rounds + i + 2, damageTaken + i + 2, won + i + 2);
+    }
+
+    resolveScalar(hp + i, attack + i, count - i, baseAttack, maxHp, rounds + i, damageTaken + i, won + i);
+}
+
+__attribute__((target("avx2")))
+static inline void resolveQuadAvx2(__m128i hpLanes, __m128i attackLanes, __m256d baseAttack,
+     __m256d maxHp, int* rounds, int* damageTaken, unsigned char* won) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+
+    __m256d monsterHp = _mm256_cvtepi32_pd(hpLanes);
+    __m256d monsterAttack = _mm256_cvtepi32_pd(attackLanes);
+    __m256d divisor = _mm256_max_pd(monsterAttack, one);
+
+    __m256d hitsToKill = _mm256_ceil_pd(_mm256_div_pd(monsterHp, baseAttack));
+    __m256d hitsTaken = _mm256_max_pd(_mm256_sub_pd(hitsToKill, one), zero);
+    __m256d hitsToDie = _mm256_ceil_pd(_mm256_div_pd(maxHp, divisor));
+
+    __m256d playerWins = _mm256_or_pd(_mm256_cmp_pd(monsterAttack, zero, _CMP_EQ_OQ),
+         _mm256_cmp_pd(hitsTaken, hitsToDie, _CMP_LT_OQ));
+    __m256d roundCount = _mm256_blendv_pd(hitsToDie, hitsToKill, playerWins);
+    __m256d damage = _mm256_blendv_pd(maxHp, _mm256_mul_pd(hitsTaken, monsterAttack), playerWins);
+
+    _mm_storeu_si128((__m128i*)rounds, _mm256_cvttpd_epi32(roundCount));
+    _mm_storeu_si128((__m128i*)damageTaken, _mm256_cvttpd_epi32(damage));
+
+    int mask = _mm256_movemask_pd(playerWins);
+
+    for (int lane = 0; lane < 4; lane++) {
+        won[lane] = (unsigned char)((mask >> lane) & 1);
+    }
+}
+
+__attribute__((target("avx2")))
+static void resolveAvx2(const int* hp, const int* attack, int count, int baseAttack, int maxHp,
+     int* rounds, int* damageTaken, unsigned char* won) {
+    const __m256d baseAttackVector = _mm256_set1_pd(baseAttack);
+    const __m256d maxHpVector = _mm256_set1_pd(maxHp);
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i hpLanes = _mm256_max_epi32(_mm256_loadu_si256((const __m256i*)(hp + i)), zero);
+        __m256i attackLanes = _mm256_max_epi32(_mm256_loadu_si256((const __m256i*)(attack + i)), zero);
+
+        resolveQuadAvx2(_mm256_castsi256_si128(hpLanes), _mm256_castsi256_si128(attackLanes),
+             baseAttackVector, maxHpVector, rounds + i, damageTaken + i, won + i);
+        resolveQuadAvx2(_mm256_extracti128_si256(hpLanes, 1), _mm256_extracti128_si256(attackLanes, 1),
+             baseAttackVector, maxHpVector, rounds + i + 4, damageTaken + i + 4, won + i + 4);
+    }
+
+    resolveScalar(hp + i, attack + i, count - i, baseAttack, maxHp, rounds + i, damageTaken + i, won + i);
+}
+
+#endif
+
+// Pick the widest kernel the running CPU supports
+static CombatKernel selectKernel() {
+#ifdef COMBAT_X86_KERNELS
+    if (__builtin_cpu_supports("avx2"))
+        return resolveAvx2;
+
+    if (__builtin_cpu_supports("sse2"))
+        return resolveSse2;
+#endif
+
+    return resolveScalar;
+}
+
+// The CPU is probed by the first batch only, later ones reuse its choice
+static _Atomic CombatKernel activeKernel = NULL;
+
+static CombatKernel currentKernel() {
+    CombatKernel kernel = atomic_load(&activeKernel);
+
+    if (kernel == NULL) {
+        kernel = selectKernel();
+        atomic_store(&activeKernel, kernel);
+    }
+
+    return kernel;
+}
+
+/* Force the kernel called "scalar", "sse2" or "avx2", e.g. to compare them.
+   Return -1 if the running CPU or the build doesn't have it */
+int useCombatKernel(const char* name) {
+    CombatKernel kernel = NULL;
+
+    if (strcmp(name, "scalar") == 0)
+        kernel = resolveScalar;
+#ifdef COMBAT_X86_KERNELS
+    else if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2"))
+        kernel = resolveSse2;
+    else if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2"))
+        kernel = resolveAvx2;
+#endif
+
+    if (kernel == NULL)
+        return -1;
+
+    atomic_store(&activeKernel, kernel);
+
+    return 0;
+}
+
+const char* combatKernelName() {
+    CombatKernel kernel = currentKernel();
+
+#ifdef COMBAT_X86_KERNELS
+    if (kernel == resolveAvx2)
+        return "avx2";
+
+    if (kernel == resolveSse2)
+        return "sse2";
+#endif
+
+    return kernel == resolveScalar ? "scalar" : "unknown";
+}
+
+// Return 0 on success, -1 if the player configuration can never finish a fight
+int resolveCombatBatch(const MonsterBatch* batch, int baseAttack, int maxHp, CombatOutcomes* outcomes) {
+    if (baseAttack <= 0 || maxHp <= 0)
+        return -1;
+
+    CombatKernel kernel = currentKernel();
+
+    kernel(batch->hp, batch->attack, batch->count, baseAttack, maxHp,
+         outcomes->rounds, outcomes->damageTaken, outcomes->won);
+
+    return 0;
+}
+
+/* Resolves every monster against each (baseAttack, maxHp) pair and stores the
+   number of won fights per pair. Invalid pairs get a win count of -1 */
+int resolveCombatSweep(const MonsterBatch* batch, const int* baseAttacks, const int* maxHps,
+     int configCount, int* winCounts) {
+    CombatOutcomes* outcomes = createCombatOutcomes(batch->count);
+
+    if (outcomes == NULL)
+        return -1;
+
+    for (int config = 0; config < configCount; config++) {
+        if (resolveCombatBatch(batch, baseAttacks[config], maxHps[config], outcomes) != 0) {
+            winCounts[config] = -1;
+
+            continue;
+        }
+
+        int wins = 0;
+
+        for (int i = 0; i < batch->count; i++) {
+            wins += outcomes->won[i];
+        }
+
+        winCounts[config] = wins;
+    }
+
+    destroyCombatOutcomes(outcomes);
+
+    return 0;
+}
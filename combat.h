@@ -0,0 +1,35 @@
+#ifndef COMBAT_H
+#define COMBAT_H
+
+#include "game.h"
+
+// Monster stats packed into parallel arrays so the resolver can stream them
+typedef struct {
+    int* hp;
+    int* attack;
+    int count;
+    int capacity;
+} MonsterBatch;
+
+// Per-monster result of a fight, one slot per monster in the batch
+typedef struct {
+    int* rounds;
+    int* damageTaken;
+    unsigned char* won;
+} CombatOutcomes;
+
+MonsterBatch* createMonsterBatch(int capacity);
+int monsterBatchAdd(MonsterBatch* batch, int hp, int attack);
+MonsterBatch* collectMonsters(GameState* gameState);
+void destroyMonsterBatch(MonsterBatch* batch);
+
+CombatOutcomes* createCombatOutcomes(int count);
+void destroyCombatOutcomes(CombatOutcomes* outcomes);
+
+int resolveCombatBatch(const MonsterBatch* batch, int baseAttack, int maxHp, CombatOutcomes* outcomes);
+int resolveCombatSweep(const MonsterBatch* batch, const int* baseAttacks, const int* maxHps,
+     int configCount, int* winCounts);
+int useCombatKernel(const char* name);
+const char* combatKernelName();
+
+#endif
@@ -1,119 +1,164 @@
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "game.h"
 #include "utils.h"
+#include "journal.h"
+#include "output.h"
+#include "validate.h"
 
 #define EXISTS_CHAR 'V'
 #define MISSING_CHAR 'X'
 
+static const char* const ITEM_TYPE_NAMES[] = {"ARMOR", "SWORD"};
+static const char* const MONSTER_TYPE_NAMES[] = {"Phantom", "Spider", "Demon", "Golem", "Cobra"};
+
+typedef struct {
+    int* ids;
+    int minX, minY;
+    int width;
+} MapBand;
+
+static void markMapCell(int x, int y, int roomId, void* context) {
+    MapBand* band = (MapBand*)context;
+
+    band->ids[(y - band->minY) * band->width + x - band->minX] = roomId;
+}
+
 // Map display functions
-static void displayMap(GameState* g) {
-    if (!g->rooms) return;
-    
-    // Find bounds
-    int minX = 0, maxX = 0, minY = 0, maxY = 0;
-    for (Room* r = g->rooms; r; r = r->next) {
-        if (r->x < minX) minX = r->x;
-        if (r->x > maxX) maxX = r->x;
-        if (r->y < minY) minY = r->y;
-        if (r->y > maxY) maxY = r->y;
-    }
+void displayMap(GameState* g) {
+    if (g->roomCount == 0 || journalIsReplaying()) return;
     
-    int width = maxX - minX + 1;
-    int height = maxY - minY + 1;
-    
-    // Create grid
-    int** grid = malloc(height * sizeof(int*));
-    for (int i = 0; i < height; i++) {
-        grid[i] = malloc(width * sizeof(int));
-        for (int j = 0; j < width; j++) grid[i][j] = -1;
-    }
-    
-    for (Room* r = g->rooms; r; r = r->next)
-        grid[r->y - minY][r->x - minX] = r->id;
+    int width = g->maxX - g->minX + 1;
+
+    // Rows are drawn one tile row at a time, so each tile is looked up once
+    MapBand band = {malloc((size_t)width * TILE_SIZE * sizeof(int)), g->minX, g->minY, width};
+    if (band.ids == NULL) return;
     
-    printf("=== SPATIAL MAP ===\n");
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            if (grid[i][j] != -1) printf("[%2d]", grid[i][j]);
-            else printf("    ");
+    outString("=== SPATIAL MAP ===\n");
+    while (band.minY <= g->maxY) {
+        int maxY = band.minY + TILE_SIZE - 1 - ((band.minY + SPATIAL_COORDINATE_OFFSET) & (TILE_SIZE - 1));
+        if (maxY > g->maxY) maxY = g->maxY;
+
+        int cells = (maxY - band.minY + 1) * width;
+        for (int i = 0; i < cells; i++) band.ids[i] = -1;
+
+        tileMapQuery(&g->tiles, g->minX, band.minY, g->maxX, maxY, markMapCell, &band);
+
+        for (int i = 0; i < cells; i++) {
+            if (band.ids[i] != -1) {
+                outChar('[');
+                outPaddedInt(band.ids[i], 2);
+                outChar(']');
+            } else {
+                outWrite("    ", 4);
+            }
+
+            if ((i + 1) % width == 0) outChar('\n');
         }
-        printf("\n");
+
+        band.minY = maxY + 1;
     }
 
-    printf("=== ROOM LEGEND ===\n");
-    for (Room* r = g->rooms; r; r = r->next) {
-        char hasItem = r->item == NULL ? MISSING_CHAR : EXISTS_CHAR;
-        char hasMonster = r->monster == NULL ? MISSING_CHAR : EXISTS_CHAR;
+    // Newest room first
+    outString("=== ROOM LEGEND ===\n");
+    for (int id = g->roomCount - 1; id >= 0; id--) {
+        Room* r = roomAt(g, id);
+        char hasItem = (r->flags & ROOM_HAS_ITEM) ? EXISTS_CHAR : MISSING_CHAR;
+        char hasMonster = (r->flags & ROOM_HAS_MONSTER) ? EXISTS_CHAR : MISSING_CHAR;
 
-        printf("ID %d: [M:%c] [I:%c]\n", r->id, hasMonster, hasItem );
+        outString("ID ");
+        outInt(r->id);
+        outString(": [M:");
+        outChar(hasMonster);
+        outString("] [I:");
+        outChar(hasItem);
+        outString("]\n");
     }
-    printf("===================\n");
+    outString("===================\n");
+
+    free(band.ids);
+}
+
+void initGame(GameState* gameState, int configMaxHp, int configBaseAttack) {
+    memset(gameState, 0, sizeof(GameState));
+    poolInit(&gameState->rooms, sizeof(Room));
+    poolInit(&gameState->monsters, sizeof(Monster));
+    poolInit(&gameState->items, sizeof(Item));
+    tileMapInit(&gameState->tiles);
+    gameState->configMaxHp = configMaxHp;
+    gameState->configBaseAttack = configBaseAttack;
+}
 
-    for (int i = 0; i < height; i++) free(grid[i]);
-    free(grid);
+Room* roomAt(GameState* g, int id) {
+    return (Room*)poolAt(&g->rooms, (unsigned int)id);
 }
 
 Room* findRoomByCoordinates(GameState* g, int x, int y) {
-    Room* currentRoom = g->rooms;
+    int id = tileMapFind(&g->tiles, x, y);
 
-    while (currentRoom != NULL) {
-        if (currentRoom->x == x && currentRoom->y == y) {
-            return currentRoom;
-        }
+    return id < 0 ? NULL : roomAt(g, id);
+}
 
-        currentRoom = currentRoom->next;
+Room* findRoomById(GameState* g, int id) {
+    if (id < 0 || id >= g->roomCount) {
+        return NULL;
     }
 
-    return NULL;
+    return roomAt(g, id);
 }
 
-Room* findRoomById(GameState* g, int id) {
-    Room* currentRoom = g->rooms;
+/* Add a new empty room at (x, y). The caller makes sure the spot is free and
+   the coordinates fit in a short */
+Room* placeRoom(GameState* gameState, int x, int y) {
+    unsigned int index = poolAdd(&gameState->rooms);
 
-    while (currentRoom != NULL) {
-        if (currentRoom->id == id) {
-            return currentRoom;
-        }
+    if (index == NO_ENTITY)
+        return NULL;
+
+    if (tileMapInsert(&gameState->tiles, x, y, (int)index) != 0) {
+        poolPop(&gameState->rooms);
 
-        currentRoom = currentRoom->next;
+        return NULL;
     }
 
-    return NULL;
-}
+    Room *newRoom = (Room*)poolAt(&gameState->rooms, index);
 
-void addRoom(GameState* gameState) {
-    Room *latestRoom = gameState->rooms;
+    if (x < gameState->minX) gameState->minX = x;
+    if (x > gameState->maxX) gameState->maxX = x;
+    if (y < gameState->minY) gameState->minY = y;
+    if (y > gameState->maxY) gameState->maxY = y;
 
-    if (latestRoom != NULL) {
-        displayMap(gameState);
-    }
+    newRoom->id = gameState->roomCount++;
+    newRoom->x = (short)x;
+    newRoom->y = (short)y;
+    newRoom->flags = 0;
 
-    Room *newRoom = malloc(sizeof(Room));
+    return newRoom;
+}
 
-    if (newRoom == NULL)
-        return;
+void addRoom(GameState* gameState) {
+    int newRoomX = 0;
+    int newRoomY = 0;
 
-    newRoom->monster = NULL;
-    newRoom->item = NULL;
-    newRoom->visited = 0;
+    if (gameState->roomCount > 0) {
+        displayMap(gameState);
 
-    if (latestRoom == NULL) {
-        newRoom->id = 0;
-        newRoom->x = 0;
-        newRoom->y = 0;
-        gameState->roomCount++;
-    } else {
         int direction; 
         int id = getInt("Attach to room ID: ");
 
         Room *roomToAttachTo = findRoomById(gameState, id);
 
+        if (roomToAttachTo == NULL) {
+            outString("No such room\n");
+
+            return;
+        }
+
         direction = getInt("Direction (0=Up,1=Down,2=Left,3=Right): ");
 
-        int newRoomX = roomToAttachTo->x;
-        int newRoomY = roomToAttachTo->y;
+        newRoomX = roomToAttachTo->x;
+        newRoomY = roomToAttachTo->y;
 
         if (direction == 0) {
             newRoomY--;
@@ -127,54 +172,107 @@ void addRoom(GameState* gameState) {
             return;
         }
 
-        if (findRoomByCoordinates(gameState, newRoomX, newRoomY) != NULL) {
-            printf("Room exists there\n");
-            free(newRoom);
+        if (newRoomX < SHRT_MIN || newRoomX > SHRT_MAX || newRoomY < SHRT_MIN || newRoomY > SHRT_MAX) {
+            outString("Room out of bounds\n");
 
             return;
         }
 
-        newRoom->id = gameState->roomCount++;
-        newRoom->x = newRoomX;
-        newRoom->y = newRoomY;
+        if (findRoomByCoordinates(gameState, newRoomX, newRoomY) != NULL) {
+            outString("Room exists there\n");
+
+            return;
+        }
     }
 
+    Room *newRoom = placeRoom(gameState, newRoomX, newRoomY);
+
+    if (newRoom == NULL)
+        return;
+
     int shouldAddMonster = getInt("Add monster? (1=Yes, 0=No): ");
 
     if (shouldAddMonster == 1) {
-        addMonster(newRoom);
+        addMonster(gameState, newRoom);
     }
 
     int shouldAddItem = getInt("Add item? (1=Yes, 0=No): ");
 
     if (shouldAddItem == 1) {
-        addItem(newRoom);
+        addItem(gameState, newRoom);
     }
 
-    newRoom->next = gameState->rooms;
-    gameState->rooms = newRoom;
+    outString("Created room ");
+    outInt(newRoom->id);
+    outString(" at (");
+    outInt(newRoom->x);
+    outChar(',');
+    outInt(newRoom->y);
+    outString(")\n");
+}
+
+// Give the room a new zeroed monster from the pool
+Monster* attachMonster(GameState* gameState, Room* room) {
+    unsigned int index = poolAdd(&gameState->monsters);
+
+    if (index == NO_ENTITY)
+        return NULL;
 
-    printf("Created room %d at (%d,%d)\n", newRoom->id, newRoom->x, newRoom->y);
+    room->monster = index;
+    room->flags |= ROOM_HAS_MONSTER;
+
+    return (Monster*)poolAt(&gameState->monsters, index);
 }
 
-void addMonster(Room* room) {
-    Monster *newMonster = malloc(sizeof(Monster));
+// Give the room a new zeroed item from the pool
+Item* attachItem(GameState* gameState, Room* room) {
+    unsigned int index = poolAdd(&gameState->items);
+
+    if (index == NO_ENTITY)
+        return NULL;
+
+    room->item = index;
+    room->flags |= ROOM_HAS_ITEM;
 
-    newMonster->name = getString("Monster name: ");
+    return (Item*)poolAt(&gameState->items, index);
+}
+
+Monster* roomMonster(GameState* gameState, Room* room) {
+    if ((room->flags & ROOM_HAS_MONSTER) == 0)
+        return NULL;
+
+    return (Monster*)poolAt(&gameState->monsters, room->monster);
+}
+
+Item* roomItem(GameState* gameState, Room* room) {
+    if ((room->flags & ROOM_HAS_ITEM) == 0)
+        return NULL;
+
+    return (Item*)poolAt(&gameState->items, room->item);
+}
+
+void addMonster(GameState* gameState, Room* room) {
+    Monster *newMonster = attachMonster(gameState, room);
+
+    if (newMonster == NULL)
+        return;
+
+    nameSet(&newMonster->name, getString("Monster name: "));
     newMonster->type = getInt("Type (0-4): ");
     newMonster->hp = getInt("HP: ");
     newMonster->attack = getInt("Attack: ");
     newMonster->maxHp = newMonster->hp;
-    room->monster = newMonster;
 }
 
-void addItem(Room* room) {
-    Item *newItem = malloc(sizeof(Item));
+void addItem(GameState* gameState, Room* room) {
+    Item *newItem = attachItem(gameState, room);
+
+    if (newItem == NULL)
+        return;
 
-    newItem->name = getString("Item name: ");
+    nameSet(&newItem->name, getString("Item name: "));
     newItem->type = getInt("Type (0=Armor, 1=Sword): ");
     newItem->value = getInt("Value: ");
-    room->item = newItem;
 }
 
 // Return 1 if left is bigger, -1 if right is bigger, 0 if identical
@@ -182,7 +280,7 @@ int compareItems(void* a, void* b) {
     Item* item1 = (Item*)a;
     Item* item2 = (Item*)b;
 
-    int compareItemNames = strcmp(item1->name, item2->name);
+    int compareItemNames = strcmp(nameText(&item1->name), nameText(&item2->name));
 
     if (compareItemNames > 0) {
         return 1;
@@ -211,7 +309,7 @@ int compareMonsters(void* a, void* b) {
     Monster* monster1 = (Monster*)a;
     Monster* monster2 = (Monster*)b;
 
-    int compareMonsterNames = strcmp(monster1->name, monster2->name);
+    int compareMonsterNames = strcmp(nameText(&monster1->name), nameText(&monster2->name));
 
     if (compareMonsterNames > 0) {
         return 1;
@@ -243,28 +341,38 @@ int compareMonsters(void* a, void* b) {
 
 void printItem(void* data) {
     Item* item = (Item*)data;
-    
-    char* typeNames[] = {"ARMOR", "SWORD"};
 
-    printf("[%s] %s - Value: %d\n", typeNames[item->type], item->name, item->value);
+    outChar('[');
+    outString(ITEM_TYPE_NAMES[item->type]);
+    outString("] ");
+    outString(nameText(&item->name));
+    outString(" - Value: ");
+    outInt(item->value);
+    outChar('\n');
 }
 
 void printMonster(void* data) {
     Monster* monster = (Monster*)data;
-    
-    char* typeNames[] = {"Phantom", "Spider", "Demon", "Golem", "Cobra"};
 
-    printf("[%s] Type: %s, Attack: %d, HP: %d\n", monster->name, typeNames[monster->type], monster->attack, monster->maxHp);
+    outChar('[');
+    outString(nameText(&monster->name));
+    outString("] Type: ");
+    outString(MONSTER_TYPE_NAMES[monster->type]);
+    outString(", Attack: ");
+    outInt(monster->attack);
+    outString(", HP: ");
+    outInt(monster->maxHp);
+    outChar('\n');
 }
 
+// Items and monsters are owned by the pools, these only release their names
 void freeItem(void* data) {
     if (data == NULL) 
         return;
 
     Item* item = (Item*)data;
 
-    free(item->name);
-    free(item);
+    nameFree(&item->name);
 }
 
 void freeMonster(void* data) {
@@ -273,13 +381,12 @@ void freeMonster(void* data) {
 
     Monster* monster = (Monster*)data;
 
-    free(monster->name);
-    free(monster);
+    nameFree(&monster->name);
 }
 
 void initPlayer(GameState* gameState) {
-    if (gameState->rooms == NULL) {
-        printf("Create rooms first\n");
+    if (gameState->roomCount == 0) {
+        outString("Create rooms first\n");
 
         return;
     }
@@ -292,7 +399,7 @@ void initPlayer(GameState* gameState) {
     Player *player = malloc(sizeof(Player));
 
     if (player == NULL) {
-        printf("Player exists\n");
+        outString("Player exists\n");
 
         return;
     }
@@ -300,28 +407,46 @@ void initPlayer(GameState* gameState) {
     player->maxHp = gameState->configMaxHp;
     player->hp = gameState->configMaxHp;
     player->baseAttack = gameState->configBaseAttack;
-    player->bag = createBST(compareItems, printItem, freeItem);
-    player->defeatedMonsters = createBST(compareMonsters, printMonster, freeMonster);
+    player->bag = createBST(compareItems, printItem);
+    player->defeatedMonsters = createBST(compareMonsters, printMonster);
     player->currentRoom=NULL;
     gameState->player = player;
 }
 
-void printRoom(Room* room, Player* player) {
-    printf("--- Room %d ---\n", room->id);
+void printRoom(GameState* gameState, Room* room) {
+    Player* player = gameState->player;
+    Monster* monster = roomMonster(gameState, room);
+    Item* item = roomItem(gameState, room);
+
+    outString("--- Room ");
+    outInt(room->id);
+    outString(" ---\n");
 
-    if (room->monster != NULL)
-        printf("Monster: %s (HP:%d)\n", room->monster->name, room->monster->hp);
+    if (monster != NULL) {
+        outString("Monster: ");
+        outString(nameText(&monster->name));
+        outString(" (HP:");
+        outInt(monster->hp);
+        outString(")\n");
+    }
 
-    if (room->item != NULL)
-        printf("Item: %s\n", room->item->name);
+    if (item != NULL) {
+        outString("Item: ");
+        outString(nameText(&item->name));
+        outChar('\n');
+    }
 
-    printf("HP: %d/%d\n", player->hp, player->maxHp);
+    outString("HP: ");
+    outInt(player->hp);
+    outChar('/');
+    outInt(player->maxHp);
+    outChar('\n');
 }
 
 // Up is Y-1, down is Y+1 according to the assignment's instructions
 void move(GameState* gameState) {
-    if (gameState->player->currentRoom->monster != NULL) {
-        printf("Kill monster first\n");
+    if (gameState->player->currentRoom->flags & ROOM_HAS_MONSTER) {
+        outString("Kill monster first\n");
 
         return;
     }
@@ -344,30 +469,29 @@ void move(GameState* gameState) {
     }
 
     if (room == NULL) {
-        printf("No room there\n");
+        outString("No room there\n");
     } else {
         gameState->player->currentRoom = room;
-        room->visited = 1;
+        room->flags |= ROOM_VISITED;
 
         if (isPlayerVictory(gameState) == 1) {
             printOnVictory();
 
-            freeGame(gameState);
-            exit(0);
+            gameState->status = EXIT_GAME;
         }
     }
 }
 
 void printOnVictory() {
-    printf("***************************************\n");
-    printf("VICTORY!\n");
-    printf("All rooms explored. All monsters defeated.\n");
-    printf("***************************************\n");
+    outString("***************************************\n");
+    outString("VICTORY!\n");
+    outString("All rooms explored. All monsters defeated.\n");
+    outString("***************************************\n");
 }
 
 int isPlayerVictory(GameState* gameState) {
-    for (Room* room = gameState->rooms; room; room = room->next) {
-        if (room->monster != NULL || room->visited == 0) {
+    for (int id = 0; id < gameState->roomCount; id++) {
+        if ((roomAt(gameState, id)->flags & (ROOM_HAS_MONSTER | ROOM_VISITED)) != ROOM_VISITED) {
             return 0;
         }
     }
@@ -379,18 +503,22 @@ int isPlayerVictory(GameState* gameState) {
    If the monster is defeated, the pointer is moved to the player's 
    defeatedMonsters BST */
 void fight(GameState* gameState) {
-    Monster *monster = gameState->player->currentRoom->monster;
+    Monster *monster = roomMonster(gameState, gameState->player->currentRoom);
     Player *player = gameState->player;
 
     if (monster == NULL) {
-        printf("No monster\n");
+        outString("No monster\n");
 
         return;
     }
 
     while (monster->hp > 0 && player->hp > 0) {
         monster->hp = monster->hp - player->baseAttack;
-        printf("You deal %d damage. Monster HP: %d\n", player->baseAttack, monster->hp < 0 ? 0 : monster->hp);
+        outString("You deal ");
+        outInt(player->baseAttack);
+        outString(" damage. Monster HP: ");
+        outInt(monster->hp < 0 ? 0 : monster->hp);
+        outChar('\n');
 
         if (monster->hp <= 0) {
             monster->hp = 0; 
@@ -399,59 +527,63 @@ void fight(GameState* gameState) {
         }
 
         player->hp = player->hp - monster->attack;
-        printf("Monster deals %d damage. Your HP: %d\n", monster->attack, player->hp);
+        outString("Monster deals ");
+        outInt(monster->attack);
+        outString(" damage. Your HP: ");
+        outInt(player->hp);
+        outChar('\n');
     }
 
     if (player->hp <= 0) {
         player->hp = 0;
 
-        printf("--- YOU DIED ---\n");
-        freeGame(gameState);
-        exit(0);
+        outString("--- YOU DIED ---\n");
+        gameState->status = EXIT_GAME;
     } else {
-        printf("Monster defeated!\n");
+        outString("Monster defeated!\n");
 
-        player->defeatedMonsters->root = bstInsert(player->defeatedMonsters->root, monster,
+        player->defeatedMonsters->root = bstCowInsert(player->defeatedMonsters->root, monster,
              player->defeatedMonsters->compare);
-        gameState->player->currentRoom->monster = NULL;
+        gameState->player->currentRoom->flags &= ~ROOM_HAS_MONSTER;
 
         if (isPlayerVictory(gameState) == 1) {
             printOnVictory();
 
-            freeGame(gameState);
-            exit(0);
+            gameState->status = EXIT_GAME;
         }
     }
 }
 
 void pickup(GameState* gameState) {
-    if (gameState->player->currentRoom->monster != NULL) {
-        printf("Kill monster first\n");
+    if (gameState->player->currentRoom->flags & ROOM_HAS_MONSTER) {
+        outString("Kill monster first\n");
 
         return;
     }
 
-    Item *item = gameState->player->currentRoom->item;
+    Item *item = roomItem(gameState, gameState->player->currentRoom);
 
     if (item == NULL) {
-        printf("No item here\n");
+        outString("No item here\n");
 
         return;
     }
 
     if (bstFind(gameState->player->bag->root, item, gameState->player->bag->compare) != NULL) {
-        printf("Duplicate item.\n");
+        outString("Duplicate item.\n");
 
         return;
     }
 
-    gameState->player->bag->root = bstInsert(gameState->player->bag->root, item, gameState->player->bag->compare);
-    gameState->player->currentRoom->item = NULL;
-    printf("Picked up %s\n", item->name);
+    gameState->player->bag->root = bstCowInsert(gameState->player->bag->root, item, gameState->player->bag->compare);
+    gameState->player->currentRoom->flags &= ~ROOM_HAS_ITEM;
+    outString("Picked up ");
+    outString(nameText(&item->name));
+    outChar('\n');
 }
 
 void bag(GameState* gameState) {
-    printf("=== INVENTORY ===\n");
+    outString("=== INVENTORY ===\n");
     int printByOrder = getInt("1.Preorder 2.Inorder 3.Postorder\n");
 
     if (printByOrder == 1) {
@@ -464,7 +596,7 @@ void bag(GameState* gameState) {
 }
 
 void defeated(GameState* gameState) {
-    printf("=== DEFEATED MONSTERS ===\n");
+    outString("=== DEFEATED MONSTERS ===\n");
     int printByOrder = getInt("1.Preorder 2.Inorder 3.Postorder\n");
     
     if (printByOrder == 1) {
@@ -478,65 +610,124 @@ void defeated(GameState* gameState) {
 
 void freeGame(GameState* gameState) {
     Player *player = gameState->player;
-    Room* room = gameState->rooms;
 
     if (player != NULL) {
         if (player->bag != NULL) {
-            bstFree(player->bag->root, player->bag->freeData);
+            bstRelease(player->bag->root);
             free(player->bag);
         }
 
         if (player->defeatedMonsters != NULL) {
-            bstFree(player->defeatedMonsters->root, player->defeatedMonsters->freeData);
+            bstRelease(player->defeatedMonsters->root);
             free(player->defeatedMonsters); 
         }
 
         free(player);
     }
 
-    while (room != NULL) {
-        Room* nextRoom = room->next;
-        freeItem(room->item);
-        freeMonster(room->monster);
-        free(room);
-        room = nextRoom;
+    // The pools own every monster and item, including those in the player's trees
+    for (unsigned int i = 0; i < gameState->monsters.count; i++) {
+        freeMonster(poolAt(&gameState->monsters, i));
+    }
+
+    for (unsigned int i = 0; i < gameState->items.count; i++) {
+        freeItem(poolAt(&gameState->items, i));
     }
 
-    gameState->rooms = NULL;
+    poolFree(&gameState->rooms);
+    poolFree(&gameState->monsters);
+    poolFree(&gameState->items);
+    tileMapFree(&gameState->tiles);
+    gameState->roomCount = 0;
+    gameState->minX = gameState->maxX = gameState->minY = gameState->maxY = 0;
     gameState->player = NULL;
 }
 
-void playGame(GameState* gameState) {
-    if (gameState->player == NULL || gameState->rooms == NULL) {
-        printf("Init player first\n");
+/* Return 0 once the player stands in a room and can take turns, -1 otherwise.
+   Rooms can be added after the player, so the world is checked on every start:
+   unreachable rooms refuse the game, a fight the player can't survive only
+   warns, as losing stays part of the game */
+int startPlay(GameState* gameState) {
+    if (gameState->player == NULL || gameState->roomCount == 0) {
+        outString("Init player first\n");
 
-        return;
+        return -1;
+    }
+
+    WorldReport report;
+
+    if (validateWorld(gameState, gameState->player->hp, gameState->player->baseAttack, &report) != 0) {
+        // Without a verdict the world is not refused, play goes on unchecked
+        if (report.checkFailed) {
+            outString("Cannot check the world, out of memory\n");
+        } else if (report.unreachableRooms > 0) {
+            outString("World invalid: ");
+            outInt(report.unreachableRooms);
+            outString(" rooms unreachable\n");
+
+            return -1;
+        } else if (!report.winnable) {
+            outString("Warning: world cannot be won with this HP and attack\n");
+        }
     }
 
     if (gameState->player->currentRoom == NULL) {
         // ensure initialization of room in start of game
         gameState->player->currentRoom = findRoomByCoordinates(gameState, 0, 0);
-        gameState->player->currentRoom->visited = 1;
+        gameState->player->currentRoom->flags |= ROOM_VISITED;
     }
 
-    int notDefeated = 1;
+    return 0;
+}
 
-    GameFunc actions[] = {move, fight, pickup, bag, defeated};
+void playGame(GameState* gameState) {
+    if (startPlay(gameState) != 0)
+        return;
+
+    int notDefeated = 1;
 
     while (notDefeated) {
-        displayMap(gameState);
-        printRoom(gameState->player->currentRoom, gameState->player);
+        int choice = playTurn(gameState);
 
-        int choice = getInt("1.Move 2.Fight 3.Pickup 4.Bag 5.Defeated 6.Quit\n");
+        // The game ended inside the action, keep it out of the journal
+        if (gameState->status == EXIT_GAME) {
+            journalDiscard();
+            notDefeated = 0;
 
-        if (choice >= 1 && choice <= 5) {
-            actions[choice - 1](gameState);
+            continue;
         }
 
+        journalCommit();
+
         if (choice == 6 || choice == INVALID_INDEX) {
             return;
         }
     }
 
     freeGame(gameState);
+}
+
+void printTurn(GameState* gameState) {
+    displayMap(gameState);
+    printRoom(gameState, gameState->player->currentRoom);
+}
+
+// Run the action of a play menu choice, anything but 1-5 does nothing
+void playChoice(GameState* gameState, int choice) {
+    GameFunc actions[] = {move, fight, pickup, bag, defeated};
+
+    if (choice >= 1 && choice <= 5) {
+        actions[choice - 1](gameState);
+    }
+}
+
+// Render the current room, read one choice and run its action. Return the choice
+int playTurn(GameState* gameState) {
+    printTurn(gameState);
+
+    int choice = getInt(PLAY_MENU);
+
+    playChoice(gameState, choice);
+
+    return choice;
 }
\ No newline at end of file
@@ -2,32 +2,44 @@
 #define GAME_H
 
 #include "bst.h"
+#include "pool.h"
+#include "spatial.h"
+#include "utils.h"
 
 typedef enum { ARMOR, SWORD } ItemType;
 typedef enum { PHANTOM, SPIDER, DEMON, GOLEM, COBRA } MonsterType;
 typedef enum { KEEP_RUNNING, EXIT_GAME } ProgramStatus;
 
+#define ROOM_VISITED 0x01
+#define ROOM_HAS_MONSTER 0x02
+#define ROOM_HAS_ITEM 0x04
+
+#define MAIN_MENU "\n=== MENU ===\n1.Add Room\n2.Init Player\n3.Play\n4.Exit\n"
+#define PLAY_MENU "1.Move 2.Fight 3.Pickup 4.Bag 5.Defeated 6.Quit\n"
+
 typedef struct Item {
-    char* name;
-    ItemType type;
+    Name name;
     int value;
+    unsigned char type;
 } Item;
 
 typedef struct Monster {
-    char* name;
-    MonsterType type;
+    Name name;
     int hp;
     int maxHp;
     int attack;
+    unsigned char type;
 } Monster;
 
+/* Rooms, monsters and items live in the GameState pools. A room's id is its
+   index in the rooms pool, monster and item are pool indices that are valid
+   while the matching ROOM_HAS_* flag is set */
 typedef struct Room {
     int id;
-    int x, y;
-    int visited;
-    Monster* monster;
-    Item* item;
-    struct Room* next;
+    short x, y;
+    unsigned int monster;
+    unsigned int item;
+    unsigned char flags;
 } Room;
 
 typedef struct Player {
@@ -40,11 +52,16 @@ typedef struct Player {
 } Player;
 
 typedef struct {
-    Room* rooms;
+    Pool rooms;
+    Pool monsters;
+    Pool items;
+    TileMap tiles;
+    int minX, maxX, minY, maxY;
     Player* player;
     int roomCount;
     int configMaxHp;
     int configBaseAttack;
+    ProgramStatus status;
 } GameState;
 
 typedef void (*GameFunc)(GameState*);
@@ -53,21 +70,33 @@ typedef void (*GameFunc)(GameState*);
 void freeMonster(void* data);
 int compareMonsters(void* a, void* b);
 void printMonster(void* data);
-void addMonster(Room* room); 
+void addMonster(GameState* g, Room* room);
+Monster* attachMonster(GameState* g, Room* room);
+Monster* roomMonster(GameState* g, Room* room);
 
 // Item functions
 void freeItem(void* data);
 int compareItems(void* a, void* b);
 void printItem(void* data);
-void addItem(Room* room); 
+void addItem(GameState* g, Room* room);
+Item* attachItem(GameState* g, Room* room);
+Item* roomItem(GameState* g, Room* room);
 
+void initGame(GameState* g, int configMaxHp, int configBaseAttack);
+Room* roomAt(GameState* g, int id);
 Room* findRoomByCoordinates(GameState* g, int x, int y);
 Room* findRoomById(GameState* g, int id);
+Room* placeRoom(GameState* g, int x, int y);
 void addRoom(GameState* g);
-void printRoom(Room* room, Player* player);
+void printRoom(GameState* g, Room* room);
+void displayMap(GameState* g);
 
 void initPlayer(GameState* g);
 void playGame(GameState* g);
+int startPlay(GameState* g);
+void printTurn(GameState* g);
+void playChoice(GameState* g, int choice);
+int playTurn(GameState* g);
 void freeGame(GameState* g);
 int isPlayerVictory(GameState* gameState);
 void printOnVictory();
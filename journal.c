@@ -0,0 +1,362 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "journal.h"
+#include "output.h"
+
+/* Journal layout: "EX6J", a format version byte, zigzag varints of the player
+   config, then one entry
+   per consumed input: a tag byte and a zigzag varint (ints), or a tag byte, a
+   varint length and the raw bytes (strings). Inputs are buffered per action and
+   appended only when the action completes, so an action that ends the process
+   (victory, death) or the final menu exit is never replayed */
+
+#define JOURNAL_MAGIC "EX6J"
+#define JOURNAL_MAGIC_LENGTH 4
+/* Bump when entries change meaning. Journals from before the version byte
+   follow the magic with the zigzag of a positive hp, an even byte, so they
+   never pass for version 1 */
+#define JOURNAL_VERSION 1
+#define JOURNAL_INT 1
+#define JOURNAL_STRING 2
+#define MAX_VARINT_BYTES 5
+#define INITIAL_PENDING_CAPACITY 64
+
+typedef struct {
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+static FILE* journalFile = NULL;
+static ByteBuffer pending = {NULL, 0, 0};
+
+static unsigned char* replayData = NULL;
+static size_t replayPosition = 0;
+static size_t replayEnd = 0;
+static int replaying = 0;
+static OutputSink* sinkBeforeReplay = NULL;
+
+static unsigned int zigzagEncode(int value) {
+    return value < 0 ? (((unsigned int)(-(value + 1))) << 1) | 1 : ((unsigned int)value) << 1;
+}
+
+static int zigzagDecode(unsigned int value) {
+    return (value & 1) ? -(int)(value >> 1) - 1 : (int)(value >> 1);
+}
+
+static int bufferReserve(ByteBuffer* buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity)
+        return 0;
+
+    size_t capacity = buffer->capacity == 0 ? INITIAL_PENDING_CAPACITY : buffer->capacity;
+
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+
+    unsigned char* data = realloc(buffer->data, capacity);
+
+    if (data == NULL)
+        return -1;
+
+    buffer->data = data;
+    buffer->capacity = capacity;
+
+    return 0;
+}
+
+static void bufferPutVarint(ByteBuffer* buffer, unsigned int value) {
+    if (bufferReserve(buffer, MAX_VARINT_BYTES) != 0)
+        return;
+
+    while (value >= 0x80) {
+        buffer->data[buffer->length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+
+    buffer->data[buffer->length++] = (unsigned char)value;
+}
+
+// Return 0 and advance the position on success, -1 if the varint is truncated
+static int readVarint(const unsigned char* data, size_t end, size_t* position, unsigned int* value) {
+    unsigned int result = 0;
+
+    for (int i = 0; i < MAX_VARINT_BYTES && *position < end; i++) {
+        unsigned char byte = data[(*position)++];
+
+        result |= (unsigned int)(byte & 0x7F) << (7 * i);
+
+        if ((byte & 0x80) == 0) {
+            *value = result;
+
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+// Return the end of the last complete entry, so a torn final write is ignored
+static size_t findValidEnd(const unsigned char* data, size_t start, size_t end) {
+    size_t position = start;
+    size_t validEnd = start;
+    unsigned int value;
+
+    while (position < end) {
+        unsigned char tag = data[position++];
+
+        if (readVarint(data, end, &position, &value) != 0)
+            break;
+
+        if (tag == JOURNAL_STRING) {
+            if (value > end - position)
+                break;
+
+            position += value;
+        } else if (tag != JOURNAL_INT) {
+            break;
+        }
+
+        validEnd = position;
+    }
+
+    return validEnd;
+}
+
+static unsigned char* readWholeFile(const char* path, size_t* length) {
+    FILE* file = fopen(path, "rb");
+    unsigned char* data = NULL;
+
+    *length = 0;
+
+    if (file == NULL)
+        return NULL;
+
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+
+        if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data = malloc(size);
+
+            if (data != NULL)
+                *length = fread(data, 1, size, file);
+        }
+    }
+
+    fclose(file);
+
+    return data;
+}
+
+// Replayed actions write to the null sink
+static void startReplay() {
+    sinkBeforeReplay = setOutputSink(nullSink());
+    replaying = 1;
+}
+
+static void endReplay() {
+    setOutputSink(sinkBeforeReplay);
+
+    free(replayData);
+    replayData = NULL;
+    replaying = 0;
+}
+
+/* Open or create the journal at path. Entries of an existing journal are
+   replayed by the next getInt/getString calls, new inputs are appended.
+   Return -1 if the file can't be used or was recorded with another config */
+int journalOpen(const char* path, int configMaxHp, int configBaseAttack) {
+    size_t length;
+    unsigned char* data = readWholeFile(path, &length);
+    ByteBuffer header = {NULL, 0, 0};
+
+    if (bufferReserve(&header, JOURNAL_MAGIC_LENGTH + 1) != 0) {
+        free(data);
+
+        return -1;
+    }
+
+    memcpy(header.data, JOURNAL_MAGIC, JOURNAL_MAGIC_LENGTH);
+    header.length = JOURNAL_MAGIC_LENGTH;
+    header.data[header.length++] = JOURNAL_VERSION;
+    bufferPutVarint(&header, zigzagEncode(configMaxHp));
+    bufferPutVarint(&header, zigzagEncode(configBaseAttack));
+
+    if (data != NULL && (length < header.length || memcmp(data, header.data, header.length) != 0)) {
+        free(header.data);
+        free(data);
+
+        return -1;
+    }
+
+    size_t validEnd = data == NULL ? 0 : findValidEnd(data, header.length, length);
+
+    // Start a fresh journal, or cut a torn tail off in place before appending to it
+    if (data == NULL) {
+        FILE* file = fopen(path, "wb");
+
+        if (file == NULL) {
+            free(header.data);
+
+            return -1;
+        }
+
+        fwrite(header.data, 1, header.length, file);
+        fclose(file);
+    } else if (validEnd < length && truncate(path, (off_t)validEnd) != 0) {
+        free(header.data);
+        free(data);
+
+        return -1;
+    }
+
+    journalFile = fopen(path, "ab");
+
+    if (journalFile == NULL) {
+        free(header.data);
+        free(data);
+
+        return -1;
+    }
+
+    if (data != NULL && validEnd > header.length) {
+        replayData = data;
+        replayPosition = header.length;
+        replayEnd = validEnd;
+        startReplay();
+    } else {
+        free(data);
+    }
+
+    free(header.data);
+
+    return 0;
+}
+
+void journalClose() {
+    if (replaying)
+        endReplay();
+
+    journalDiscard();
+
+    if (journalFile != NULL) {
+        fclose(journalFile);
+        journalFile = NULL;
+    }
+
+    free(pending.data);
+    pending.data = NULL;
+    pending.capacity = 0;
+}
+
+int journalIsReplaying() {
+    return replaying;
+}
+
+/* The next entry doesn't fit the prompt, the journal was recorded with other
+   menus. Cut it off from that entry on, so new inputs continue the prefix that
+   did replay instead of landing behind entries no replay can reach. If that
+   fails, stop recording rather than write a journal that replays wrong */
+static void abandonReplay() {
+    off_t validEnd = (off_t)replayPosition;
+
+    endReplay();
+
+    if (fflush(journalFile) != 0 || ftruncate(fileno(journalFile), validEnd) != 0) {
+        fclose(journalFile);
+        journalFile = NULL;
+    }
+}
+
+// Leave replay mode as soon as the last entry is served, so play resumes interactively
+static void finishEntry() {
+    if (replayPosition >= replayEnd)
+        endReplay();
+}
+
+int journalReplayInt(int* value) {
+    unsigned int encoded = 0;
+
+    if (!replaying)
+        return 0;
+
+    if (replayData[replayPosition] != JOURNAL_INT) {
+        abandonReplay();
+
+        return 0;
+    }
+
+    replayPosition++;
+    readVarint(replayData, replayEnd, &replayPosition, &encoded);
+    *value = zigzagDecode(encoded);
+    finishEntry();
+
+    return 1;
+}
+
+int journalReplayString(char** string) {
+    unsigned int length = 0;
+
+    if (!replaying)
+        return 0;
+
+    if (replayData[replayPosition] != JOURNAL_STRING) {
+        abandonReplay();
+
+        return 0;
+    }
+
+    replayPosition++;
+    readVarint(replayData, replayEnd, &replayPosition, &length);
+
+    *string = malloc(length + 1);
+
+    if (*string != NULL) {
+        memcpy(*string, replayData + replayPosition, length);
+        (*string)[length] = '\0';
+    }
+
+    replayPosition += length;
+    finishEntry();
+
+    return 1;
+}
+
+void journalRecordInt(int value) {
+    if (journalFile == NULL || bufferReserve(&pending, 1) != 0)
+        return;
+
+    pending.data[pending.length++] = JOURNAL_INT;
+    bufferPutVarint(&pending, zigzagEncode(value));
+}
+
+void journalRecordString(const char* string) {
+    size_t length = strlen(string);
+
+    if (journalFile == NULL || bufferReserve(&pending, 1 + MAX_VARINT_BYTES + length) != 0)
+        return;
+
+    pending.data[pending.length++] = JOURNAL_STRING;
+    bufferPutVarint(&pending, (unsigned int)length);
+    memcpy(pending.data + pending.length, string, length);
+    pending.length += length;
+}
+
+// Append the inputs of the finished action to the journal
+void journalCommit() {
+    if (journalFile == NULL || pending.length == 0)
+        return;
+
+    fwrite(pending.data, 1, pending.length, journalFile);
+    fflush(journalFile);
+    pending.length = 0;
+}
+
+void journalDiscard() {
+    pending.length = 0;
+}
@@ -0,0 +1,18 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+int journalOpen(const char* path, int configMaxHp, int configBaseAttack);
+void journalClose();
+int journalIsReplaying();
+
+// Replay side: return 1 and fill the value if it came from the journal
+int journalReplayInt(int* value);
+int journalReplayString(char** string);
+
+// Record side: inputs of the running action are kept until it is committed
+void journalRecordInt(int value);
+void journalRecordString(const char* string);
+void journalCommit();
+void journalDiscard();
+
+#endif
@@ -1,31 +1,57 @@
-#include <stdio.h>
 #include <stdlib.h>
 #include "game.h"
 #include "utils.h"
+#include "journal.h"
+#include "output.h"
 
 typedef void (*ActionFunc)(GameState*);
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        printf("Usage: %s <player_hp> <base_attack>\n", argv[0]);
+    if (argc != 3 && argc != 4) {
+        outString("Usage: ");
+        outString(argv[0]);
+        outString(" <player_hp> <base_attack> [journal_file]\n");
+        outFlush();
         return 1;
     }
 
-    GameState game = {0};
-    game.configMaxHp = atoi(argv[1]);
-    game.configBaseAttack = atoi(argv[2]);
+    GameState game;
+    initGame(&game, atoi(argv[1]), atoi(argv[2]));
+
+    // Replay the recorded session, then keep recording to the same journal
+    if (argc == 4 && journalOpen(argv[3], game.configMaxHp, game.configBaseAttack) != 0) {
+        outString("Cannot use journal ");
+        outString(argv[3]);
+        outChar('\n');
+        outFlush();
+        return 1;
+    }
 
     ActionFunc actions[] = {NULL, addRoom, initPlayer, playGame};
 
     int running = 1;
     while (running) {
-        printf("\n=== MENU ===\n1.Add Room\n2.Init Player\n3.Play\n4.Exit\n");
+        outString(MAIN_MENU);
         int c = getInt("Choice: ");
         
-        if (c == 4 || c == INVALID_INDEX) running = 0;
-        else if (c >= 1 && c <= 3) actions[c](&game);
+        if (c == 4 || c == INVALID_INDEX) {
+            running = 0;
+            journalDiscard();
+        } else {
+            if (c >= 1 && c <= 3) actions[c](&game);
+
+            // Victory or death ends the program like the Exit choice
+            if (game.status == EXIT_GAME) {
+                running = 0;
+                journalDiscard();
+            } else {
+                journalCommit();
+            }
+        }
     }
 
+    journalClose();
     freeGame(&game);
+    outFlush();
     return 0;
 }
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "output.h"
+
+#define MAX_INT_DIGITS 11
+
+static void writeStdout(void* context, const char* data, size_t length) {
+    (void)context;
+
+    fwrite(data, 1, length, stdout);
+    fflush(stdout);
+}
+
+static char stdoutBuffer[OUTPUT_BUFFER_SIZE];
+static OutputSink stdoutSinkInstance = {writeStdout, NULL, stdoutBuffer, 0, OUTPUT_BUFFER_SIZE};
+static OutputSink nullSinkInstance = {NULL, NULL, NULL, 0, 0};
+// Each thread writes to its own current sink, so server workers don't share one
+static _Thread_local OutputSink* currentSink = &stdoutSinkInstance;
+
+OutputSink* createOutputSink(SinkWriteFunc write, void* context, size_t capacity) {
+    OutputSink* sink = malloc(sizeof(OutputSink));
+
+    if (sink == NULL)
+        return NULL;
+
+    sink->buffer = malloc(capacity);
+
+    if (sink->buffer == NULL) {
+        free(sink);
+
+        return NULL;
+    }
+
+    sink->write = write;
+    sink->context = context;
+    sink->length = 0;
+    sink->capacity = capacity;
+
+    return sink;
+}
+
+static void flushSink(OutputSink* sink) {
+    if (sink->length > 0) {
+        sink->write(sink->context, sink->buffer, sink->length);
+        sink->length = 0;
+    }
+}
+
+void destroyOutputSink(OutputSink* sink) {
+    if (sink == NULL)
+        return;
+
+    flushSink(sink);
+
+    if (currentSink == sink)
+        currentSink = &stdoutSinkInstance;
+
+    free(sink->buffer);
+    free(sink);
+}
+
+OutputSink* stdoutSink() {
+    return &stdoutSinkInstance;
+}
+
+OutputSink* nullSink() {
+    return &nullSinkInstance;
+}
+
+// Make sink the current one and return the previous sink, flushed
+OutputSink* setOutputSink(OutputSink* sink) {
+    OutputSink* previous = currentSink;
+
+    if (previous->write != NULL)
+        flushSink(previous);
+
+    currentSink = sink;
+
+    return previous;
+}
+
+void outWrite(const char* data, size_t length) {
+    OutputSink* sink = currentSink;
+
+    if (sink->write == NULL)
+        return;
+
+    if (length > sink->capacity - sink->length) {
+        flushSink(sink);
+
+        // Too big to be worth copying, hand it to the sink directly
+        if (length >= sink->capacity) {
+            sink->write(sink->context, data, length);
+
+            return;
+        }
+    }
+
+    memcpy(sink->buffer + sink->length, data, length);
+    sink->length += length;
+}
+
+void outString(const char* string) {
+    outWrite(string, strlen(string));
+}
+
+void outChar(char character) {
+    OutputSink* sink = currentSink;
+
+    if (sink->write == NULL)
+        return;
+
+    if (sink->length == sink->capacity)
+        flushSink(sink);
+
+    sink->buffer[sink->length++] = character;
+}
+
+// Same output as printf("%*d", width, value)
+void outPaddedInt(int value, int width) {
+    char digits[MAX_INT_DIGITS + 1];
+    int start = sizeof(digits);
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    do {
+        digits[--start] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0)
+        digits[--start] = '-';
+
+    for (int padding = width - ((int)sizeof(digits) - start); padding > 0; padding--) {
+        outChar(' ');
+    }
+
+    outWrite(digits + start, sizeof(digits) - start);
+}
+
+void outInt(int value) {
+    outPaddedInt(value, 0);
+}
+
+void outFlush() {
+    if (currentSink->write != NULL)
+        flushSink(currentSink);
+}
@@ -0,0 +1,33 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+typedef void (*SinkWriteFunc)(void* context, const char* data, size_t length);
+
+// Buffered destination for game output. A sink without a write function discards everything
+typedef struct {
+    SinkWriteFunc write;
+    void* context;
+    char* buffer;
+    size_t length;
+    size_t capacity;
+} OutputSink;
+
+OutputSink* createOutputSink(SinkWriteFunc write, void* context, size_t capacity);
+void destroyOutputSink(OutputSink* sink);
+OutputSink* stdoutSink();
+OutputSink* nullSink();
+OutputSink* setOutputSink(OutputSink* sink);
+
+// Writes go to the current sink
+void outWrite(const char* data, size_t length);
+void outString(const char* string);
+void outChar(char character);
+void outInt(int value);
+void outPaddedInt(int value, int width);
+void outFlush();
+
+#endif
@@ -0,0 +1,57 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+#define INITIAL_CHUNK_CAPACITY 4
+
+void poolInit(Pool* pool, size_t elementSize) {
+    pool->chunks = NULL;
+    pool->chunkCount = 0;
+    pool->chunkCapacity = 0;
+    pool->count = 0;
+    pool->elementSize = elementSize;
+}
+
+// Return the index of a new zeroed element, or NO_ENTITY on allocation failure
+unsigned int poolAdd(Pool* pool) {
+    if (pool->count == pool->chunkCount * POOL_CHUNK_SIZE) {
+        if (pool->chunkCount == pool->chunkCapacity) {
+            unsigned int capacity = pool->chunkCapacity == 0 ? INITIAL_CHUNK_CAPACITY : pool->chunkCapacity * 2;
+            char** chunks = realloc(pool->chunks, capacity * sizeof(char*));
+
+            if (chunks == NULL)
+                return NO_ENTITY;
+
+            pool->chunks = chunks;
+            pool->chunkCapacity = capacity;
+        }
+
+        char* chunk = malloc(POOL_CHUNK_SIZE * pool->elementSize);
+
+        if (chunk == NULL)
+            return NO_ENTITY;
+
+        pool->chunks[pool->chunkCount++] = chunk;
+    }
+
+    unsigned int index = pool->count++;
+
+    memset(poolAt(pool, index), 0, pool->elementSize);
+
+    return index;
+}
+
+// Drop the most recently added element, e.g. to undo a poolAdd whose caller failed
+void poolPop(Pool* pool) {
+    if (pool->count > 0)
+        pool->count--;
+}
+
+void poolFree(Pool* pool) {
+    for (unsigned int i = 0; i < pool->chunkCount; i++) {
+        free(pool->chunks[i]);
+    }
+
+    free(pool->chunks);
+    poolInit(pool, pool->elementSize);
+}
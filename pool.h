@@ -0,0 +1,29 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+#define POOL_CHUNK_SHIFT 10
+#define POOL_CHUNK_SIZE (1u << POOL_CHUNK_SHIFT)
+#define NO_ENTITY 0xFFFFFFFFu
+
+/* Typed storage addressed by 32-bit indices. Elements live in fixed-size
+   chunks, so pointers to them stay valid while the pool grows */
+typedef struct {
+    char** chunks;
+    unsigned int chunkCount;
+    unsigned int chunkCapacity;
+    unsigned int count;
+    size_t elementSize;
+} Pool;
+
+void poolInit(Pool* pool, size_t elementSize);
+unsigned int poolAdd(Pool* pool);
+void poolPop(Pool* pool);
+void poolFree(Pool* pool);
+
+static inline void* poolAt(const Pool* pool, unsigned int index) {
+    return pool->chunks[index >> POOL_CHUNK_SHIFT] + (index & (POOL_CHUNK_SIZE - 1)) * pool->elementSize;
+}
+
+#endif
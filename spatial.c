@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <string.h>
+#include "spatial.h"
+
+#define INITIAL_TILE_CAPACITY 16
+#define INITIAL_TILE_ROOMS 8
+#define TILE_MASK (TILE_SIZE - 1)
+#define MIN_COORDINATE (-SPATIAL_COORDINATE_OFFSET)
+#define MAX_COORDINATE (SPATIAL_COORDINATE_OFFSET - 1)
+
+static int bitCount(unsigned int bits) {
+#ifdef __GNUC__
+    return __builtin_popcount(bits);
+#else
+    int count = 0;
+
+    while (bits != 0) {
+        bits &= bits - 1;
+        count++;
+    }
+
+    return count;
+#endif
+}
+
+static int lowestBit(unsigned int bits) {
+#ifdef __GNUC__
+    return __builtin_ctz(bits);
+#else
+    int index = 0;
+
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+
+    return index;
+#endif
+}
+
+static int toTile(int coordinate) {
+    return (coordinate + SPATIAL_COORDINATE_OFFSET) >> TILE_SHIFT;
+}
+
+static int toCell(int coordinate) {
+    return (coordinate + SPATIAL_COORDINATE_OFFSET) & TILE_MASK;
+}
+
+static int fromCell(int tile, int cell) {
+    return (tile << TILE_SHIFT) + cell - SPATIAL_COORDINATE_OFFSET;
+}
+
+static int inRange(int coordinate) {
+    return coordinate >= MIN_COORDINATE && coordinate <= MAX_COORDINATE;
+}
+
+static unsigned int hashTile(int tileX, int tileY) {
+    unsigned int key = ((unsigned int)tileX << 16) | (unsigned int)tileY;
+
+    key ^= key >> 16;
+    key *= 0x85EBCA6Bu;
+    key ^= key >> 13;
+    key *= 0xC2B2AE35u;
+    key ^= key >> 16;
+
+    return key;
+}
+
+// Return the slot holding the tile, or the empty slot where it would go
+static int findSlot(const Tile* tiles, int capacity, int tileX, int tileY) {
+    int slot = (int)(hashTile(tileX, tileY) & (unsigned int)(capacity - 1));
+
+    while (tiles[slot].roomCount != 0 && (tiles[slot].tileX != tileX || tiles[slot].tileY != tileY)) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+
+    return slot;
+}
+
+static const Tile* findTile(const TileMap* map, int tileX, int tileY) {
+    if (map->count == 0)
+        return NULL;
+
+    const Tile* tile = &map->tiles[findSlot(map->tiles, map->capacity, tileX, tileY)];
+
+    return tile->roomCount == 0 ? NULL : tile;
+}
+
+static int growTable(TileMap* map) {
+    int capacity = map->capacity == 0 ? INITIAL_TILE_CAPACITY : map->capacity * 2;
+    Tile* tiles = calloc(capacity, sizeof(Tile));
+
+    if (tiles == NULL)
+        return -1;
+
+    for (int i = 0; i < map->capacity; i++) {
+        if (map->tiles[i].roomCount != 0)
+            tiles[findSlot(tiles, capacity, map->tiles[i].tileX, map->tiles[i].tileY)] = map->tiles[i];
+    }
+
+    free(map->tiles);
+    map->tiles = tiles;
+    map->capacity = capacity;
+
+    return 0;
+}
+
+void tileMapInit(TileMap* map) {
+    map->tiles = NULL;
+    map->capacity = 0;
+    map->count = 0;
+}
+
+void tileMapFree(TileMap* map) {
+    for (int i = 0; i < map->capacity; i++) {
+        free(map->tiles[i].roomIds);
+    }
+
+    free(map->tiles);
+    tileMapInit(map);
+}
+
+// Return 0 on success, -1 if the cell is taken, out of range or memory runs out
+int tileMapInsert(TileMap* map, int x, int y, int roomId) {
+    if (!inRange(x) || !inRange(y))
+        return -1;
+
+    if ((map->count + 1) * 2 > map->capacity && growTable(map) != 0)
+        return -1;
+
+    int tileX = toTile(x);
+    int tileY = toTile(y);
+    Tile* tile = &map->tiles[findSlot(map->tiles, map->capacity, tileX, tileY)];
+    int row = toCell(y);
+    unsigned int bit = 1u << toCell(x);
+
+    if (tile->occupancy[row] & bit)
+        return -1;
+
+    if (tile->roomCount == tile->capacity) {
+        int capacity = tile->capacity == 0 ? INITIAL_TILE_ROOMS : tile->capacity * 2;
+        int* roomIds = realloc(tile->roomIds, capacity * sizeof(int));
+
+        if (roomIds == NULL)
+            return -1;
+
+        tile->roomIds = roomIds;
+        tile->capacity = capacity;
+    }
+
+    if (tile->roomCount == 0) {
+        tile->tileX = tileX;
+        tile->tileY = tileY;
+        map->count++;
+    }
+
+    int rank = tile->rowStart[row] + bitCount(tile->occupancy[row] & (bit - 1));
+
+    memmove(tile->roomIds + rank + 1, tile->roomIds + rank, (tile->roomCount - rank) * sizeof(int));
+    tile->roomIds[rank] = roomId;
+    tile->roomCount++;
+    tile->occupancy[row] |= bit;
+
+    for (int nextRow = row + 1; nextRow < TILE_SIZE; nextRow++) {
+        tile->rowStart[nextRow]++;
+    }
+
+    return 0;
+}
+
+// Return the id of the room at (x, y), or -1 if there is none
+int tileMapFind(const TileMap* map, int x, int y) {
+    if (!inRange(x) || !inRange(y))
+        return -1;
+
+    const Tile* tile = findTile(map, toTile(x), toTile(y));
+
+    if (tile == NULL)
+        return -1;
+
+    int row = toCell(y);
+    unsigned int bit = 1u << toCell(x);
+
+    if ((tile->occupancy[row] & bit) == 0)
+        return -1;
+
+    return tile->roomIds[tile->rowStart[row] + bitCount(tile->occupancy[row] & (bit - 1))];
+}
+
+/* Visit every room inside the rectangle. Each overlapping tile is looked up
+   once and only its rows inside the rectangle are scanned */
+void tileMapQuery(const TileMap* map, int minX, int minY, int maxX, int maxY, TileVisitFunc visit, void* context) {
+    if (minX < MIN_COORDINATE) minX = MIN_COORDINATE;
+    if (minY < MIN_COORDINATE) minY = MIN_COORDINATE;
+    if (maxX > MAX_COORDINATE) maxX = MAX_COORDINATE;
+    if (maxY > MAX_COORDINATE) maxY = MAX_COORDINATE;
+
+    if (minX > maxX || minY > maxY)
+        return;
+
+    for (int tileY = toTile(minY); tileY <= toTile(maxY); tileY++) {
+        int firstRow = tileY == toTile(minY) ? toCell(minY) : 0;
+        int lastRow = tileY == toTile(maxY) ? toCell(maxY) : TILE_MASK;
+
+        for (int tileX = toTile(minX); tileX <= toTile(maxX); tileX++) {
+            const Tile* tile = findTile(map, tileX, tileY);
+
+            if (tile == NULL)
+                continue;
+
+            for (int row = firstRow; row <= lastRow; row++) {
+                int y = fromCell(tileY, row);
+                unsigned int bits = tile->occupancy[row];
+                int rank = tile->rowStart[row];
+
+                while (bits != 0) {
+                    int x = fromCell(tileX, lowestBit(bits));
+
+                    if (x >= minX && x <= maxX)
+                        visit(x, y, tile->roomIds[rank], context);
+
+                    bits &= bits - 1;
+                    rank++;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#define TILE_SHIFT 5
+#define TILE_SIZE (1 << TILE_SHIFT)
+#define SPATIAL_COORDINATE_OFFSET 32768
+
+/* A 32x32 block of the room grid. Each occupancy word is one row of cells,
+   and roomIds holds the ids of the occupied cells in row-major order, so a
+   cell's id is found by counting the set bits before it */
+typedef struct {
+    int tileX, tileY;
+    unsigned int occupancy[TILE_SIZE];
+    unsigned short rowStart[TILE_SIZE];
+    int* roomIds;
+    int roomCount;
+    int capacity;
+} Tile;
+
+// Open-addressing table of the non-empty tiles, keyed by tile coordinates
+typedef struct {
+    Tile* tiles;
+    int capacity;
+    int count;
+} TileMap;
+
+typedef void (*TileVisitFunc)(int x, int y, int roomId, void* context);
+
+void tileMapInit(TileMap* map);
+void tileMapFree(TileMap* map);
+int tileMapInsert(TileMap* map, int x, int y, int roomId);
+int tileMapFind(const TileMap* map, int x, int y);
+void tileMapQuery(const TileMap* map, int minX, int minY, int maxX, int maxY, TileVisitFunc visit, void* context);
+
+#endif
@@ -0,0 +1,89 @@
+/* Helpers shared by the tools: a monotonic clock, a Unix socket connect and
+   latency percentiles. Link it into any tool that includes bench.h */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench.h"
+
+#define INITIAL_SAMPLE_CAPACITY 1024
+
+double nowSeconds() {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// Return a connected stream socket, or -1 if the path is too long or nobody listens on it
+int connectTo(const char* path) {
+    struct sockaddr_un address;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+        return -1;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// A sample that finds no memory is dropped
+void addSample(LatencySamples* latency, double sample) {
+    if (latency->count == latency->capacity) {
+        int capacity = latency->capacity == 0 ? INITIAL_SAMPLE_CAPACITY : latency->capacity * 2;
+        double* samples = realloc(latency->samples, capacity * sizeof(double));
+
+        if (samples == NULL)
+            return;
+
+        latency->samples = samples;
+        latency->capacity = capacity;
+    }
+
+    latency->samples[latency->count++] = sample;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double first = *(const double*)a;
+    double second = *(const double*)b;
+
+    return (first > second) - (first < second);
+}
+
+void sortSamples(LatencySamples* latency) {
+    if (latency->count > 0)
+        qsort(latency->samples, latency->count, sizeof(double), compareDoubles);
+}
+
+// The samples must be sorted first
+double percentile(const LatencySamples* latency, double fraction) {
+    if (latency->count == 0)
+        return 0;
+
+    return latency->samples[(int)(fraction * (latency->count - 1))];
+}
+
+void freeSamples(LatencySamples* latency) {
+    free(latency->samples);
+    latency->samples = NULL;
+    latency->count = 0;
+    latency->capacity = 0;
+}
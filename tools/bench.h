@@ -0,0 +1,19 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Latency samples in seconds, grown as they come in
+typedef struct {
+    double* samples;
+    int count;
+    int capacity;
+} LatencySamples;
+
+double nowSeconds();
+int connectTo(const char* path);
+
+void addSample(LatencySamples* latency, double sample);
+void sortSamples(LatencySamples* latency);
+double percentile(const LatencySamples* latency, double fraction);
+void freeSamples(LatencySamples* latency);
+
+#endif
@@ -0,0 +1,170 @@
+/* Persistent BST check: grows a family of versions with bstSnapshot and
+   bstCowInsert, verifies that every version keeps exactly its own contents
+   while newer ones are derived from it, then releases the versions in random
+   order. The trees don't own the values, the check frees them at the end.
+   Build from the repository root (add -fsanitize=address to catch leaks):
+   gcc -std=c11 -O2 -I. tools/bstcheck.c bst.c -o bstcheck
+   Usage: bstcheck [versions] [inserts_per_version] [seed] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bst.h"
+
+#define DEFAULT_VERSIONS 200
+#define DEFAULT_INSERTS 20
+#define VALUE_RANGE 1000
+
+typedef struct {
+    BSTNode* root;
+    int* values;
+    int count;
+    int released;
+} Version;
+
+static int* visited;
+static int visitedCount;
+
+static int compareInts(void* a, void* b) {
+    int first = *(int*)a;
+    int second = *(int*)b;
+
+    return (first > second) - (first < second);
+}
+
+static int compareValues(const void* a, const void* b) {
+    return compareInts((void*)a, (void*)b);
+}
+
+static void collectValue(void* data) {
+    visited[visitedCount++] = *(int*)data;
+}
+
+// Return 1 if the inorder walk of the version gives exactly its sorted values
+static int versionMatches(const Version* version) {
+    visitedCount = 0;
+    bstInorder(version->root, collectValue);
+
+    return visitedCount == version->count && memcmp(visited, version->values, version->count * sizeof(int)) == 0;
+}
+
+static int checkLiveVersions(const Version* versions, int versionCount) {
+    int bad = 0;
+
+    for (int i = 0; i < versionCount; i++) {
+        if (!versions[i].released && !versionMatches(&versions[i]))
+            bad++;
+    }
+
+    return bad;
+}
+
+int main(int argc, char* argv[]) {
+    int versionCount = argc > 1 ? atoi(argv[1]) : DEFAULT_VERSIONS;
+    int insertCount = argc > 2 ? atoi(argv[2]) : DEFAULT_INSERTS;
+    unsigned int seed = argc > 3 ? (unsigned int)atoi(argv[3]) : 1;
+
+    if (versionCount < 1 || insertCount < 1) {
+        fprintf(stderr, "Usage: %s [versions] [inserts_per_version] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    srand(seed);
+
+    Version* versions = calloc(versionCount, sizeof(Version));
+    int* order = malloc(versionCount * sizeof(int));
+    int** allocated = malloc((size_t)versionCount * insertCount * sizeof(int*));
+
+    // A version holds at most every value inserted along its chain of parents
+    visited = malloc((size_t)versionCount * insertCount * sizeof(int));
+
+    if (versions == NULL || order == NULL || allocated == NULL || visited == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    int allocatedCount = 0;
+    int bad = 0;
+
+    // Version 0 starts empty, every other one extends a random earlier version
+    for (int v = 0; v < versionCount; v++) {
+        Version* parent = v == 0 ? NULL : &versions[rand() % v];
+        Version* version = &versions[v];
+        int parentCount = parent == NULL ? 0 : parent->count;
+
+        version->root = parent == NULL ? NULL : bstSnapshot(parent->root);
+        version->values = malloc((parentCount + insertCount) * sizeof(int));
+
+        if (version->values == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+
+        if (parentCount > 0)
+            memcpy(version->values, parent->values, parentCount * sizeof(int));
+
+        version->count = parentCount;
+
+        for (int i = 0; i < insertCount; i++) {
+            int* value = malloc(sizeof(int));
+
+            if (value == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+
+            *value = rand() % VALUE_RANGE;
+            version->root = bstCowInsert(version->root, value, compareInts);
+            version->values[version->count++] = *value;
+            allocated[allocatedCount++] = value;
+        }
+
+        qsort(version->values, version->count, sizeof(int), compareValues);
+
+        // Deriving this version must leave every older one untouched
+        if (parent != NULL && !versionMatches(parent))
+            bad++;
+    }
+
+    bad += checkLiveVersions(versions, versionCount);
+
+    for (int i = 0; i < versionCount; i++) {
+        order[i] = i;
+    }
+
+    for (int i = versionCount - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int swap = order[i];
+
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    // Releasing a version must not disturb the ones still sharing its nodes
+    for (int i = 0; i < versionCount; i++) {
+        Version* version = &versions[order[i]];
+
+        bstRelease(version->root);
+        version->released = 1;
+
+        if (i % 16 == 0)
+            bad += checkLiveVersions(versions, versionCount);
+    }
+
+    for (int i = 0; i < versionCount; i++) {
+        free(versions[i].values);
+    }
+
+    for (int i = 0; i < allocatedCount; i++) {
+        free(allocated[i]);
+    }
+
+    free(versions);
+    free(order);
+    free(allocated);
+    free(visited);
+
+    printf("versions=%d inserted=%d bad_versions=%d\n", versionCount, allocatedCount, bad);
+
+    return bad == 0 ? 0 : 1;
+}
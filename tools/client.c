@@ -0,0 +1,94 @@
+/* Line client for the game server: sends each stdin line as one request and
+   prints the response. See tools/server.c for the protocol.
+   Build from the repository root:
+   gcc -std=c11 -O2 tools/client.c tools/bench.c -o client
+   Usage: client <socket_path> */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "bench.h"
+
+typedef enum { RESPONSE_MORE, RESPONSE_LAST, RESPONSE_BROKEN } ResponseEnd;
+
+static int sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+
+        if (sent <= 0)
+            return -1;
+
+        data += sent;
+        length -= (size_t)sent;
+    }
+
+    return 0;
+}
+
+// Print one response without its dot-stuffing and report how it ended
+static ResponseEnd printResponse(FILE* server) {
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    ResponseEnd end = RESPONSE_BROKEN;
+
+    while ((length = getline(&line, &capacity, server)) > 0) {
+        if (strcmp(line, ".\n") == 0) {
+            end = RESPONSE_MORE;
+            break;
+        }
+
+        if (strcmp(line, ".end\n") == 0) {
+            end = RESPONSE_LAST;
+            break;
+        }
+
+        fputs(line[0] == '.' ? line + 1 : line, stdout);
+    }
+
+    fflush(stdout);
+    free(line);
+
+    return end;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <socket_path>\n", argv[0]);
+        return 1;
+    }
+
+    int fd = connectTo(argv[1]);
+    FILE* server = fd < 0 ? NULL : fdopen(fd, "r");
+
+    if (server == NULL) {
+        fprintf(stderr, "Cannot connect to %s\n", argv[1]);
+        return 1;
+    }
+
+    ResponseEnd end = printResponse(server);
+    char* request = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+
+    while (end == RESPONSE_MORE && (length = getline(&request, &capacity, stdin)) > 0) {
+        if (sendAll(fd, request, (size_t)length) != 0
+             || (request[length - 1] != '\n' && sendAll(fd, "\n", 1) != 0))
+            break;
+
+        end = printResponse(server);
+    }
+
+    free(request);
+    fclose(server);
+
+    if (end == RESPONSE_BROKEN) {
+        fprintf(stderr, "Connection lost\n");
+        return 1;
+    }
+
+    return 0;
+}
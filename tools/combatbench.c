@@ -0,0 +1,167 @@
+/* Combat resolver driver: checks every kernel the CPU supports against a
+   replay of the fight() loop, then times a sweep of player configs over a
+   large monster batch and reports matchups per second per kernel.
+   Build from the repository root:
+   gcc -std=c11 -O2 -pthread -I. tools/combatbench.c tools/bench.c bst.c combat.c game.c journal.c output.c \
+       pool.c spatial.c utils.c validate.c -o combatbench
+   Usage: combatbench [monsters] [configs] [seed] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "combat.h"
+
+#define DEFAULT_MONSTERS (1 << 20)
+#define DEFAULT_CONFIGS 64
+#define CHECK_MONSTERS 1003
+#define CHECK_CONFIGS 200
+#define KERNEL_COUNT 3
+
+static const char* const KERNEL_NAMES[KERNEL_COUNT] = {"scalar", "sse2", "avx2"};
+
+/* The fight() loop without output: the player strikes first, the monster
+   answers while alive. Negative monster attack is treated as 0, the way the
+   resolver documents it */
+static void simulateFight(int monsterHp, int monsterAttack, int baseAttack, int maxHp,
+     int* rounds, int* damageTaken, unsigned char* won) {
+    int playerHp = maxHp;
+
+    if (monsterAttack < 0)
+        monsterAttack = 0;
+
+    *rounds = 0;
+
+    while (monsterHp > 0 && playerHp > 0) {
+        (*rounds)++;
+        monsterHp -= baseAttack;
+
+        if (monsterHp <= 0)
+            break;
+
+        playerHp -= monsterAttack;
+    }
+
+    *won = (unsigned char)(playerHp > 0);
+    *damageTaken = playerHp > 0 ? maxHp - playerHp : maxHp;
+}
+
+// Return the number of outcomes that differ from the simulation, or -1 if memory runs out
+static int checkKernel() {
+    MonsterBatch* batch = createMonsterBatch(CHECK_MONSTERS);
+    CombatOutcomes* outcomes = createCombatOutcomes(CHECK_MONSTERS);
+    int mismatches = 0;
+
+    if (batch == NULL || outcomes == NULL) {
+        destroyMonsterBatch(batch);
+        destroyCombatOutcomes(outcomes);
+
+        return -1;
+    }
+
+    // Odd count and non-positive stats cover the scalar tails and the clamping
+    for (int i = 0; i < CHECK_MONSTERS; i++) {
+        monsterBatchAdd(batch, rand() % 210 - 10, rand() % 35 - 5);
+    }
+
+    for (int config = 0; config < CHECK_CONFIGS; config++) {
+        int baseAttack = 1 + rand() % 40;
+        int maxHp = 1 + rand() % 300;
+
+        resolveCombatBatch(batch, baseAttack, maxHp, outcomes);
+
+        for (int i = 0; i < batch->count; i++) {
+            int rounds, damageTaken;
+            unsigned char won;
+
+            simulateFight(batch->hp[i], batch->attack[i], baseAttack, maxHp, &rounds, &damageTaken, &won);
+
+            if (rounds != outcomes->rounds[i] || damageTaken != outcomes->damageTaken[i] || won != outcomes->won[i])
+                mismatches++;
+        }
+    }
+
+    destroyMonsterBatch(batch);
+    destroyCombatOutcomes(outcomes);
+
+    return mismatches;
+}
+
+static double timeSweep(const MonsterBatch* batch, const int* baseAttacks, const int* maxHps, int configCount,
+     int* winCounts) {
+    double start = nowSeconds();
+
+    if (resolveCombatSweep(batch, baseAttacks, maxHps, configCount, winCounts) != 0)
+        return -1;
+
+    return nowSeconds() - start;
+}
+
+int main(int argc, char* argv[]) {
+    int monsterCount = argc > 1 ? atoi(argv[1]) : DEFAULT_MONSTERS;
+    int configCount = argc > 2 ? atoi(argv[2]) : DEFAULT_CONFIGS;
+    unsigned int seed = argc > 3 ? (unsigned int)atoi(argv[3]) : 1;
+
+    if (monsterCount < 1 || configCount < 1) {
+        fprintf(stderr, "Usage: %s [monsters] [configs] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    srand(seed);
+
+    const char* defaultKernel = combatKernelName();
+    MonsterBatch* batch = createMonsterBatch(monsterCount);
+    int* baseAttacks = malloc(configCount * sizeof(int));
+    int* maxHps = malloc(configCount * sizeof(int));
+    int* winCounts = malloc(configCount * sizeof(int));
+    int* referenceWins = malloc(configCount * sizeof(int));
+    int failed = 0;
+
+    if (batch == NULL || baseAttacks == NULL || maxHps == NULL || winCounts == NULL || referenceWins == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (int i = 0; i < monsterCount; i++) {
+        monsterBatchAdd(batch, rand() % 1000, rand() % 50);
+    }
+
+    for (int config = 0; config < configCount; config++) {
+        baseAttacks[config] = 1 + config % 40;
+        maxHps[config] = 100 + config * 10;
+    }
+
+    fprintf(stderr, "default kernel: %s\n", defaultKernel);
+    fprintf(stderr, "  %-7s %10s %14s\n", "kernel", "mismatches", "matchups/s");
+
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (useCombatKernel(KERNEL_NAMES[k]) != 0) {
+            fprintf(stderr, "  %-7s %10s\n", KERNEL_NAMES[k], "n/a");
+            continue;
+        }
+
+        int mismatches = checkKernel();
+        double seconds = timeSweep(batch, baseAttacks, maxHps, configCount, winCounts);
+
+        // Every kernel must also agree with the scalar one on the whole sweep
+        for (int config = 0; config < configCount && seconds >= 0; config++) {
+            if (k == 0)
+                referenceWins[config] = winCounts[config];
+            else if (winCounts[config] != referenceWins[config])
+                mismatches++;
+        }
+
+        if (mismatches != 0 || seconds < 0)
+            failed = 1;
+
+        fprintf(stderr, "  %-7s %10d %14.0f\n", KERNEL_NAMES[k], mismatches,
+             seconds > 0 ? (double)monsterCount * configCount / seconds : 0);
+    }
+
+    destroyMonsterBatch(batch);
+    free(baseAttacks);
+    free(maxHps);
+    free(winCounts);
+    free(referenceWins);
+
+    return failed;
+}
@@ -0,0 +1,275 @@
+/* Load-test driver: builds worlds of growing size, feeds a random command
+   stream through the play loop and reports latency percentiles per command.
+   Each turn is scripted from the live game through an InputSource, and the
+   run stops if a turn doesn't read exactly the answers scripted for it.
+   Rendering the turn (map and room) is timed as its own row, so it doesn't
+   hide the cost of the actions.
+   Build from the repository root:
+   gcc -std=c11 -O2 -pthread -I. tools/loadtest.c tools/bench.c bst.c combat.c game.c journal.c output.c pool.c \
+       spatial.c utils.c validate.c -o loadtest
+   Usage: loadtest [max_rooms] [commands_per_world] [seed] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "game.h"
+#include "output.h"
+#include "utils.h"
+
+#define DEFAULT_MAX_ROOMS 10000
+#define DEFAULT_COMMANDS 20000
+#define MIN_ROOMS 10
+#define PLAYER_HP 1000000000
+#define PLAYER_ATTACK 10
+#define NAME_LENGTH 32
+#define COMMAND_TYPES 5
+#define RENDER_ROW COMMAND_TYPES
+#define REPORT_ROWS (COMMAND_TYPES + 1)
+#define MAX_ANSWERS 2
+#define ANSWER_LENGTH 16
+
+typedef enum { CMD_MOVE, CMD_FIGHT, CMD_PICKUP, CMD_BAG, CMD_DEFEATED } CommandType;
+
+static const char* const ROW_NAMES[REPORT_ROWS] = {"move", "fight", "pickup", "bag", "defeated", "render"};
+
+// Share of the stream per command type, in percent
+static const int COMMAND_WEIGHTS[COMMAND_TYPES] = {50, 20, 15, 10, 5};
+
+static void setName(Name* name, const char* prefix, int id) {
+    char* text = malloc(NAME_LENGTH);
+
+    if (text != NULL)
+        snprintf(text, NAME_LENGTH, "%s%d", prefix, id);
+
+    nameSet(name, text);
+}
+
+static void addRandomMonster(GameState* gameState, Room* room) {
+    Monster* monster = attachMonster(gameState, room);
+
+    if (monster == NULL)
+        return;
+
+    setName(&monster->name, "monster", room->id);
+    monster->type = (unsigned char)(rand() % 5);
+    monster->hp = 1 + rand() % 100;
+    monster->maxHp = monster->hp;
+    monster->attack = 1 + rand() % 10;
+}
+
+static void addRandomItem(GameState* gameState, Room* room) {
+    Item* item = attachItem(gameState, room);
+
+    if (item == NULL)
+        return;
+
+    setName(&item->name, "item", room->id);
+    item->type = (unsigned char)(rand() % 2);
+    item->value = rand() % 1000;
+}
+
+/* Grow a connected world from (0, 0) by attaching rooms to random existing
+   rooms, then add one room diagonal to the bounding box. No move can reach
+   it, so the stream never ends the game with a victory */
+static int buildWorld(GameState* gameState, int roomCount) {
+    static const int dx[] = {0, 0, -1, 1};
+    static const int dy[] = {-1, 1, 0, 0};
+    Room** rooms = malloc(roomCount * sizeof(Room*));
+    int minX = 0, minY = 0;
+
+    if (rooms == NULL)
+        return -1;
+
+    rooms[0] = placeRoom(gameState, 0, 0);
+
+    if (rooms[0] == NULL) {
+        free(rooms);
+
+        return -1;
+    }
+
+    int placed = 1;
+
+    while (placed < roomCount) {
+        Room* base = rooms[rand() % placed];
+        int direction = rand() % 4;
+        int x = base->x + dx[direction];
+        int y = base->y + dy[direction];
+
+        if (findRoomByCoordinates(gameState, x, y) != NULL)
+            continue;
+
+        Room* room = placeRoom(gameState, x, y);
+
+        if (room == NULL)
+            break;
+
+        if (rand() % 100 < 30)
+            addRandomMonster(gameState, room);
+
+        if (rand() % 100 < 30)
+            addRandomItem(gameState, room);
+
+        if (x < minX) minX = x;
+        if (y < minY) minY = y;
+
+        rooms[placed++] = room;
+    }
+
+    free(rooms);
+
+    initPlayer(gameState);
+
+    if (gameState->player == NULL || placeRoom(gameState, minX - 1, minY - 1) == NULL)
+        return -1;
+
+    gameState->player->currentRoom = findRoomByCoordinates(gameState, 0, 0);
+    gameState->player->currentRoom->flags |= ROOM_VISITED;
+
+    return 0;
+}
+
+static CommandType randomCommand() {
+    int roll = rand() % 100;
+    int type = 0;
+
+    while (roll >= COMMAND_WEIGHTS[type]) {
+        roll -= COMMAND_WEIGHTS[type];
+        type++;
+    }
+
+    return (CommandType)type;
+}
+
+/* Script one turn from the live game: a move out of a room that still has
+   its monster is refused before the direction is read, so it becomes a
+   fight. Fill tokens with exactly the answers the turn reads and return
+   their count */
+static int scriptTurn(GameState* gameState, CommandType* command, char answers[][ANSWER_LENGTH], char** tokens) {
+    CommandType type = randomCommand();
+    int count = 0;
+
+    if (type == CMD_MOVE && (gameState->player->currentRoom->flags & ROOM_HAS_MONSTER))
+        type = CMD_FIGHT;
+
+    snprintf(answers[count++], ANSWER_LENGTH, "%d", type + 1);
+
+    if (type == CMD_MOVE)
+        snprintf(answers[count++], ANSWER_LENGTH, "%d", rand() % 4);
+    else if (type == CMD_BAG || type == CMD_DEFEATED)
+        snprintf(answers[count++], ANSWER_LENGTH, "%d", 1 + rand() % 3);
+
+    for (int i = 0; i < count; i++) {
+        tokens[i] = answers[i];
+    }
+
+    *command = type;
+
+    return count;
+}
+
+static void printReport(int roomCount, int commandCount, double totalSeconds, LatencySamples* latencies) {
+    fprintf(stderr, "rooms=%d commands=%d throughput=%.0f cmd/s\n", roomCount, commandCount,
+         commandCount / totalSeconds);
+    fprintf(stderr, "  %-9s %8s %10s %10s %10s\n", "command", "count", "p50(us)", "p99(us)", "p999(us)");
+
+    for (int row = 0; row < REPORT_ROWS; row++) {
+        LatencySamples* latency = &latencies[row];
+
+        sortSamples(latency);
+        fprintf(stderr, "  %-9s %8d %10.1f %10.1f %10.1f\n", ROW_NAMES[row], latency->count,
+             percentile(latency, 0.5) * 1e6, percentile(latency, 0.99) * 1e6, percentile(latency, 0.999) * 1e6);
+    }
+}
+
+static int runWorld(int roomCount, int commandCount) {
+    GameState game;
+    LatencySamples latencies[REPORT_ROWS] = {{NULL, 0, 0}};
+    char answers[MAX_ANSWERS][ANSWER_LENGTH];
+    char* tokens[MAX_ANSWERS];
+    InputSource input = {tokens, 0, 0};
+    int result = -1;
+
+    initGame(&game, PLAYER_HP, PLAYER_ATTACK);
+
+    if (buildWorld(&game, roomCount) != 0) {
+        fprintf(stderr, "rooms=%d: could not build the world\n", roomCount);
+    } else {
+        double start = nowSeconds();
+        int executed = 0;
+        int desynced = 0;
+
+        setInputSource(&input);
+
+        while (executed < commandCount && game.status != EXIT_GAME) {
+            CommandType command;
+
+            input.count = scriptTurn(&game, &command, answers, tokens);
+            input.next = 0;
+
+            // playTurn split in its parts, so render and action are timed apart
+            double before = nowSeconds();
+
+            printTurn(&game);
+
+            double rendered = nowSeconds();
+            int choice = getInt(PLAY_MENU);
+            double chosen = nowSeconds();
+
+            playChoice(&game, choice);
+
+            double done = nowSeconds();
+
+            // A turn that left answers unread or ran short would skew every later sample
+            if (choice != (int)command + 1 || input.next != input.count) {
+                desynced = 1;
+                break;
+            }
+
+            addSample(&latencies[RENDER_ROW], rendered - before);
+            addSample(&latencies[command], done - chosen);
+            executed++;
+        }
+
+        setInputSource(NULL);
+
+        if (desynced) {
+            fprintf(stderr, "rooms=%d: turn %d did not read its scripted answers\n", roomCount, executed);
+        } else {
+            printReport(roomCount, executed, nowSeconds() - start, latencies);
+            result = 0;
+        }
+    }
+
+    for (int row = 0; row < REPORT_ROWS; row++) {
+        freeSamples(&latencies[row]);
+    }
+
+    freeGame(&game);
+
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int maxRooms = argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_ROOMS;
+    int commandCount = argc > 2 ? atoi(argv[2]) : DEFAULT_COMMANDS;
+    unsigned int seed = argc > 3 ? (unsigned int)atoi(argv[3]) : 1;
+
+    if (maxRooms < MIN_ROOMS || commandCount < 1) {
+        fprintf(stderr, "Usage: %s [max_rooms >= %d] [commands_per_world] [seed]\n", argv[0], MIN_ROOMS);
+        return 1;
+    }
+
+    // Game output is not part of the measurement, the report goes to stderr
+    setOutputSink(nullSink());
+
+    srand(seed);
+
+    for (int roomCount = MIN_ROOMS; roomCount <= maxRooms; roomCount *= 10) {
+        if (runWorld(roomCount, commandCount) != 0)
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,765 @@
+/* Multi-session game server: many independent worlds served from one process
+   over a Unix domain socket. One thread runs the epoll loop and owns every
+   socket, a fixed pool of workers runs the game actions.
+   Build from the repository root:
+   gcc -std=c11 -O2 -pthread -I. tools/server.c arena.c bst.c combat.c game.c journal.c output.c pool.c \
+       spatial.c utils.c validate.c -o server
+   Usage: server <socket_path> <player_hp> <base_attack> [workers]
+
+   Protocol, one request line at a time, mirroring the stdin menus:
+   - A request is a menu choice followed by the answers to the prompts it
+     triggers, all separated by '|', e.g. "1|0|3|1|Rat|1|5|2|0|0" attaches a
+     room right of room 0 with a monster and no item. Missing answers read
+     like stdin at EOF, extra ones are ignored.
+   - Choice 3 of the main menu starts playing. From then on every line is one
+     play menu choice with its answers, e.g. "1|3" moves right, until 6 goes
+     back to the main menu.
+   - The server greets with the main menu. Every response ends with a line
+     holding only ".", game lines starting with '.' get an extra '.'.
+   - Exit, an unreadable menu choice, victory and death end the session. The
+     last response ends with ".end" instead and the server hangs up. */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "arena.h"
+#include "game.h"
+#include "output.h"
+#include "utils.h"
+
+#define SESSION_LINE_LIMIT 4096
+#define SESSION_ARENA_BLOCK 8192
+#define MAX_REQUEST_TOKENS 64
+#define FIELD_SEPARATOR '|'
+#define MAX_WORKERS 64
+#define MAX_EVENTS 256
+#define INITIAL_OUTPUT_CAPACITY 1024
+
+typedef enum { SESSION_MENU, SESSION_PLAYING } SessionState;
+
+/* One connection and its world. While busy, only the worker running its
+   request touches it; otherwise only the event loop does */
+typedef struct Session {
+    Arena arena;
+    int fd;
+    SessionState state;
+    GameState game;
+    char* input;
+    size_t inputLength;
+    size_t requestLength;
+    char** tokens;
+    // Pending response bytes, released as soon as they are sent
+    char* output;
+    size_t outputLength;
+    size_t outputSent;
+    size_t outputCapacity;
+    int atLineStart;
+    unsigned int watched;
+    int busy;
+    int closing;
+    int closed;
+    int inputClosed;
+    int hungUp;
+    struct Session* nextQueued;
+    struct Session* prev;
+    struct Session* next;
+} Session;
+
+typedef struct {
+    int listenFd;
+    int epollFd;
+    int wakeFd;
+    int acceptPaused;
+    int configMaxHp;
+    int configBaseAttack;
+    pthread_mutex_t lock;
+    pthread_cond_t workAvailable;
+    Session* workHead;
+    Session* workTail;
+    Session* doneHead;
+    int stopping;
+    Session* sessions;
+    Session* closedSessions;
+    int sessionCount;
+    long long servedSessions;
+} Server;
+
+typedef struct {
+    Server* server;
+    OutputSink* sink;
+    pthread_t thread;
+} Worker;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int signalNumber) {
+    (void)signalNumber;
+
+    stopRequested = 1;
+}
+
+// A session that runs out of memory drops the output and is hung up on
+static void appendOutput(Session* session, const char* data, size_t length) {
+    if (session->outputLength + length > session->outputCapacity) {
+        size_t capacity = session->outputCapacity == 0 ? INITIAL_OUTPUT_CAPACITY : session->outputCapacity;
+
+        while (capacity < session->outputLength + length) {
+            capacity *= 2;
+        }
+
+        char* output = realloc(session->output, capacity);
+
+        if (output == NULL) {
+            session->closing = 1;
+
+            return;
+        }
+
+        session->output = output;
+        session->outputCapacity = capacity;
+    }
+
+    memcpy(session->output + session->outputLength, data, length);
+    session->outputLength += length;
+}
+
+// Sink write function: append to the session's response, doubling a leading '.'
+static void writeToSession(void* context, const char* data, size_t length) {
+    Session* session = (Session*)context;
+    size_t start = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        if (session->atLineStart && data[i] == '.') {
+            appendOutput(session, data + start, i - start);
+            appendOutput(session, ".", 1);
+            start = i;
+        }
+
+        session->atLineStart = data[i] == '\n';
+    }
+
+    appendOutput(session, data + start, length - start);
+}
+
+static void finishResponse(Session* session) {
+    if (!session->atLineStart)
+        appendOutput(session, "\n", 1);
+
+    if (session->closing)
+        appendOutput(session, ".end\n", 5);
+    else
+        appendOutput(session, ".\n", 2);
+
+    session->atLineStart = 1;
+}
+
+static void runMenuChoice(Session* session, int choice) {
+    GameState* game = &session->game;
+
+    if (choice == 1) {
+        addRoom(game);
+    } else if (choice == 2) {
+        initPlayer(game);
+    } else if (choice == 3) {
+        if (startPlay(game) == 0) {
+            session->state = SESSION_PLAYING;
+            printTurn(game);
+            outString(PLAY_MENU);
+
+            return;
+        }
+    } else if (choice == 4 || choice == INVALID_INDEX) {
+        session->closing = 1;
+
+        return;
+    }
+
+    outString(MAIN_MENU);
+}
+
+static void runPlayChoice(Session* session, int choice) {
+    GameState* game = &session->game;
+
+    playChoice(game, choice);
+
+    // Victory or death ends the session like it ends the program
+    if (game->status == EXIT_GAME) {
+        session->closing = 1;
+
+        return;
+    }
+
+    if (choice == 6 || choice == INVALID_INDEX) {
+        session->state = SESSION_MENU;
+        outString(MAIN_MENU);
+
+        return;
+    }
+
+    printTurn(game);
+    outString(PLAY_MENU);
+}
+
+// Split the request line in place and feed its fields to the game's prompts
+static void runRequest(Session* session) {
+    char* line = session->input;
+    size_t length = session->requestLength - 1;
+    int count = 0;
+
+    if (length > 0 && line[length - 1] == '\r')
+        length--;
+
+    line[length] = '\0';
+
+    char* field = line;
+
+    // Every token ends at its separator, the fields past the last token are dropped like any extra answer
+    while (field != NULL && count < MAX_REQUEST_TOKENS) {
+        char* separator = strchr(field, FIELD_SEPARATOR);
+
+        session->tokens[count++] = field;
+
+        if (separator != NULL)
+            *separator++ = '\0';
+
+        field = separator;
+    }
+
+    InputSource input = {session->tokens, count, 0};
+    InputSource* previous = setInputSource(&input);
+
+    if (session->state == SESSION_MENU)
+        runMenuChoice(session, getInt("Choice: "));
+    else
+        runPlayChoice(session, getInt(PLAY_MENU));
+
+    setInputSource(previous);
+}
+
+static void* workerMain(void* argument) {
+    Worker* worker = (Worker*)argument;
+    Server* server = worker->server;
+    uint64_t wake = 1;
+
+    setOutputSink(worker->sink);
+
+    while (1) {
+        pthread_mutex_lock(&server->lock);
+
+        while (!server->stopping && server->workHead == NULL) {
+            pthread_cond_wait(&server->workAvailable, &server->lock);
+        }
+
+        Session* session = server->workHead;
+
+        if (session == NULL) {
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+
+        server->workHead = session->nextQueued;
+
+        if (server->workHead == NULL)
+            server->workTail = NULL;
+
+        pthread_mutex_unlock(&server->lock);
+
+        worker->sink->context = session;
+        runRequest(session);
+        outFlush();
+        finishResponse(session);
+
+        pthread_mutex_lock(&server->lock);
+        session->nextQueued = server->doneHead;
+        server->doneHead = session;
+        pthread_mutex_unlock(&server->lock);
+
+        // The event loop picks the finished session up from doneHead
+        if (write(server->wakeFd, &wake, sizeof(wake)) < 0 && errno != EAGAIN)
+            perror("write");
+    }
+
+    return NULL;
+}
+
+static void submitRequest(Server* server, Session* session) {
+    session->nextQueued = NULL;
+
+    pthread_mutex_lock(&server->lock);
+
+    if (server->workTail == NULL)
+        server->workHead = session;
+    else
+        server->workTail->nextQueued = session;
+
+    server->workTail = session;
+    pthread_cond_signal(&server->workAvailable);
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void watchSession(Server* server, Session* session, unsigned int events) {
+    struct epoll_event event;
+
+    if (session->watched == events)
+        return;
+
+    event.events = events;
+    event.data.ptr = session;
+
+    if (epoll_ctl(server->epollFd, EPOLL_CTL_MOD, session->fd, &event) == 0)
+        session->watched = events;
+}
+
+static void watchListener(Server* server, unsigned int events) {
+    struct epoll_event event;
+
+    event.events = events;
+    event.data.ptr = &server->listenFd;
+    epoll_ctl(server->epollFd, EPOLL_CTL_MOD, server->listenFd, &event);
+}
+
+/* Unlink the session and close its socket. The memory is released after the
+   current batch of events, which may still name the session */
+static void closeSession(Server* server, Session* session) {
+    close(session->fd);
+    session->closed = 1;
+
+    if (session->prev != NULL)
+        session->prev->next = session->next;
+    else
+        server->sessions = session->next;
+
+    if (session->next != NULL)
+        session->next->prev = session->prev;
+
+    session->next = server->closedSessions;
+    server->closedSessions = session;
+    server->sessionCount--;
+
+    if (server->acceptPaused) {
+        server->acceptPaused = 0;
+        watchListener(server, EPOLLIN);
+    }
+}
+
+static void destroySession(Session* session) {
+    Arena arena = session->arena;
+
+    freeGame(&session->game);
+    free(session->output);
+    arenaFree(&arena);
+}
+
+static void releaseClosedSessions(Server* server) {
+    while (server->closedSessions != NULL) {
+        Session* session = server->closedSessions;
+
+        server->closedSessions = session->next;
+        destroySession(session);
+    }
+}
+
+// Return 0 once everything is sent or the socket is full, -1 if the peer is gone
+static int flushOutput(Session* session) {
+    while (session->outputSent < session->outputLength) {
+        ssize_t sent = send(session->fd, session->output + session->outputSent,
+             session->outputLength - session->outputSent, MSG_NOSIGNAL);
+
+        if (sent < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+
+        session->outputSent += (size_t)sent;
+    }
+
+    free(session->output);
+    session->output = NULL;
+    session->outputLength = 0;
+    session->outputSent = 0;
+    session->outputCapacity = 0;
+
+    return 0;
+}
+
+/* Move an idle session forward: send its pending response, then hand its
+   next complete line to the workers, or wait for the socket. A new request
+   only starts once the previous response is fully sent */
+static void advanceSession(Server* server, Session* session) {
+    if (session->busy || session->closed)
+        return;
+
+    if (session->hungUp || flushOutput(session) != 0) {
+        closeSession(server, session);
+
+        return;
+    }
+
+    if (session->outputLength > 0) {
+        watchSession(server, session, EPOLLOUT);
+
+        return;
+    }
+
+    if (session->closing) {
+        closeSession(server, session);
+
+        return;
+    }
+
+    char* end = memchr(session->input, '\n', session->inputLength);
+
+    if (end != NULL) {
+        session->requestLength = (size_t)(end - session->input) + 1;
+        session->busy = 1;
+        watchSession(server, session, 0);
+        submitRequest(server, session);
+
+        return;
+    }
+
+    if (session->inputLength == SESSION_LINE_LIMIT) {
+        session->closing = 1;
+        writeToSession(session, "Line too long\n", 14);
+        finishResponse(session);
+        advanceSession(server, session);
+
+        return;
+    }
+
+    if (session->inputClosed) {
+        closeSession(server, session);
+
+        return;
+    }
+
+    watchSession(server, session, EPOLLIN);
+}
+
+static Session* createSession(Server* server, int fd) {
+    Arena arena;
+
+    arenaInit(&arena, SESSION_ARENA_BLOCK);
+
+    Session* session = arenaAlloc(&arena, sizeof(Session));
+    char* input = arenaAlloc(&arena, SESSION_LINE_LIMIT);
+    char** tokens = arenaAlloc(&arena, MAX_REQUEST_TOKENS * sizeof(char*));
+
+    if (session == NULL || input == NULL || tokens == NULL) {
+        arenaFree(&arena);
+
+        return NULL;
+    }
+
+    session->arena = arena;
+    session->fd = fd;
+    session->state = SESSION_MENU;
+    session->input = input;
+    session->tokens = tokens;
+    session->atLineStart = 1;
+    initGame(&session->game, server->configMaxHp, server->configBaseAttack);
+
+    struct epoll_event event;
+
+    event.events = EPOLLIN;
+    event.data.ptr = session;
+
+    if (epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        arenaFree(&arena);
+
+        return NULL;
+    }
+
+    session->watched = EPOLLIN;
+    session->next = server->sessions;
+
+    if (server->sessions != NULL)
+        server->sessions->prev = session;
+
+    server->sessions = session;
+    server->sessionCount++;
+    server->servedSessions++;
+
+    return session;
+}
+
+static void acceptSessions(Server* server) {
+    while (1) {
+        int fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0) {
+            // Out of descriptors: stop listening until a session closes
+            if (errno == EMFILE || errno == ENFILE) {
+                server->acceptPaused = 1;
+                watchListener(server, 0);
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                perror("accept");
+            }
+
+            return;
+        }
+
+        Session* session = createSession(server, fd);
+
+        if (session == NULL) {
+            close(fd);
+            continue;
+        }
+
+        // Greet with the main menu, the same text the stdin game starts with
+        writeToSession(session, MAIN_MENU, strlen(MAIN_MENU));
+        finishResponse(session);
+        advanceSession(server, session);
+    }
+}
+
+static void collectFinished(Server* server) {
+    uint64_t count;
+
+    if (read(server->wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        perror("read");
+
+    pthread_mutex_lock(&server->lock);
+    Session* session = server->doneHead;
+    server->doneHead = NULL;
+    pthread_mutex_unlock(&server->lock);
+
+    while (session != NULL) {
+        Session* next = session->nextQueued;
+
+        memmove(session->input, session->input + session->requestLength,
+             session->inputLength - session->requestLength);
+        session->inputLength -= session->requestLength;
+        session->requestLength = 0;
+        session->busy = 0;
+        advanceSession(server, session);
+
+        session = next;
+    }
+}
+
+static void handleSessionEvent(Server* server, Session* session, unsigned int events) {
+    if (session->closed)
+        return;
+
+    // A stale readiness event can arrive after the session went busy
+    if ((events & EPOLLIN) && !session->busy) {
+        ssize_t received = recv(session->fd, session->input + session->inputLength,
+             SESSION_LINE_LIMIT - session->inputLength, 0);
+
+        if (received > 0)
+            session->inputLength += (size_t)received;
+        else if (received == 0)
+            session->inputClosed = 1;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            session->hungUp = 1;
+    } else if (events & (EPOLLERR | EPOLLHUP)) {
+        session->hungUp = 1;
+
+        // Stop the hang-up from firing again while a worker finishes the request
+        if (session->busy)
+            epoll_ctl(server->epollFd, EPOLL_CTL_DEL, session->fd, NULL);
+    }
+
+    advanceSession(server, session);
+}
+
+static int runEventLoop(Server* server) {
+    struct epoll_event events[MAX_EVENTS];
+
+    while (!stopRequested) {
+        int count = epoll_wait(server->epollFd, events, MAX_EVENTS, -1);
+
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+
+            perror("epoll_wait");
+            return -1;
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* tag = events[i].data.ptr;
+
+            if (tag == &server->listenFd)
+                acceptSessions(server);
+            else if (tag == &server->wakeFd)
+                collectFinished(server);
+            else
+                handleSessionEvent(server, (Session*)tag, events[i].events);
+        }
+
+        releaseClosedSessions(server);
+    }
+
+    return 0;
+}
+
+static int listenOn(const char* path) {
+    struct sockaddr_un address;
+    struct stat status;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+
+    // Replace a socket left behind by an earlier run, but never another kind of file
+    if (stat(path, &status) == 0 && S_ISSOCK(status.st_mode))
+        unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int addToEpoll(int epollFd, int fd, void* tag) {
+    struct epoll_event event;
+
+    event.events = EPOLLIN;
+    event.data.ptr = tag;
+
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+// Run workers with signals blocked, so SIGINT always interrupts the event loop
+static int startWorkers(Server* server, Worker* workers, int workerCount) {
+    sigset_t blocked, previous;
+    int started = 0;
+
+    sigfillset(&blocked);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+
+    for (int i = 0; i < workerCount; i++) {
+        workers[i].server = server;
+        workers[i].sink = createOutputSink(writeToSession, NULL, OUTPUT_BUFFER_SIZE);
+
+        if (workers[i].sink == NULL || pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]) != 0) {
+            destroyOutputSink(workers[i].sink);
+            break;
+        }
+
+        started++;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    return started;
+}
+
+static void stopWorkers(Server* server, Worker* workers, int workerCount) {
+    pthread_mutex_lock(&server->lock);
+    server->stopping = 1;
+    pthread_cond_broadcast(&server->workAvailable);
+    pthread_mutex_unlock(&server->lock);
+
+    for (int i = 0; i < workerCount; i++) {
+        pthread_join(workers[i].thread, NULL);
+        // The sink is flushed after every request, nothing is left to write
+        workers[i].sink->context = NULL;
+        workers[i].sink->length = 0;
+        destroyOutputSink(workers[i].sink);
+    }
+}
+
+static int chooseWorkerCount(const char* argument) {
+    long count = argument != NULL ? atol(argument) : sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (count < 1)
+        return 1;
+
+    return count > MAX_WORKERS ? MAX_WORKERS : (int)count;
+}
+
+int main(int argc, char* argv[]) {
+    Server server;
+    Worker workers[MAX_WORKERS];
+    struct sigaction action;
+
+    if (argc != 4 && argc != 5) {
+        fprintf(stderr, "Usage: %s <socket_path> <player_hp> <base_attack> [workers]\n", argv[0]);
+        return 1;
+    }
+
+    memset(&server, 0, sizeof(server));
+    server.configMaxHp = atoi(argv[2]);
+    server.configBaseAttack = atoi(argv[3]);
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.workAvailable, NULL);
+
+    server.listenFd = listenOn(argv[1]);
+    server.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    server.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (server.listenFd < 0 || server.epollFd < 0 || server.wakeFd < 0
+         || addToEpoll(server.epollFd, server.listenFd, &server.listenFd) != 0
+         || addToEpoll(server.epollFd, server.wakeFd, &server.wakeFd) != 0) {
+        fprintf(stderr, "Cannot start the server on %s\n", argv[1]);
+        return 1;
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    int workerCount = startWorkers(&server, workers, chooseWorkerCount(argc == 5 ? argv[4] : NULL));
+
+    if (workerCount == 0) {
+        fprintf(stderr, "Cannot start workers\n");
+        unlink(argv[1]);
+        return 1;
+    }
+
+    fprintf(stderr, "Listening on %s with %d workers\n", argv[1], workerCount);
+
+    int result = runEventLoop(&server);
+
+    stopWorkers(&server, workers, workerCount);
+
+    while (server.sessions != NULL) {
+        closeSession(&server, server.sessions);
+    }
+
+    releaseClosedSessions(&server);
+    close(server.wakeFd);
+    close(server.epollFd);
+    close(server.listenFd);
+    unlink(argv[1]);
+    pthread_cond_destroy(&server.workAvailable);
+    pthread_mutex_destroy(&server.lock);
+
+    fprintf(stderr, "Served %lld sessions\n", server.servedSessions);
+
+    return result == 0 ? 0 : 1;
+}
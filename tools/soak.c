@@ -0,0 +1,406 @@
+/* Soak test for the game server: keeps many sessions open at once and drives
+   each through building a world, playing it and starting over, checking every
+   response along the way. Reports throughput, request latency percentiles
+   and, given the server's pid, its resident memory per idle session.
+   Build from the repository root:
+   gcc -std=c11 -O2 -pthread tools/soak.c tools/bench.c -o soak
+   Usage: soak <socket_path> [sessions] [seconds] [threads] [server_pid]
+   Every monster here has 1 hp, so any server config with positive hp and
+   attack makes the worlds winnable. One world in DOOMED_SHARE ends instead in
+   an ogre no config below 2000000000 hp and attack survives: Play must warn
+   that it can't be won, and the game must end in death. */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "bench.h"
+
+#define DEFAULT_SESSIONS 1000
+#define DEFAULT_SECONDS 10
+#define DEFAULT_THREADS 8
+#define ROOMS_PER_WORLD 12
+#define MAX_TURNS_PER_GAME 200
+#define MAX_REQUEST_LENGTH 128
+#define DOOMED_SHARE 8
+#define UNWINNABLE_WARNING "Warning: world cannot be won"
+
+typedef enum { RESPONSE_MORE, RESPONSE_LAST, RESPONSE_BROKEN } ResponseEnd;
+typedef enum { STEP_BUILD, STEP_INIT, STEP_START, STEP_PLAY } SessionStep;
+
+typedef struct {
+    int fd;
+    FILE* stream;
+    SessionStep step;
+    int roomsBuilt;
+    int turns;
+    int doomed;
+    unsigned int random;
+} SoakSession;
+
+typedef struct {
+    const char* path;
+    SoakSession* sessions;
+    int sessionCount;
+    unsigned int seed;
+    double deadline;
+    pthread_barrier_t* connected;
+    LatencySamples latency;
+    long long requests;
+    long long games;
+    long long deaths;
+    long long errors;
+    pthread_t thread;
+} SoakThread;
+
+// xorshift32, one state per session so threads never share a generator
+static unsigned int nextRandom(unsigned int* state) {
+    unsigned int value = *state;
+
+    value ^= value << 13;
+    value ^= value >> 17;
+    value ^= value << 5;
+    *state = value;
+
+    return value;
+}
+
+/* Read one response into text (truncated to capacity) and report how it
+   ended. A missing terminator counts as broken */
+static ResponseEnd readResponse(FILE* stream, char* text, size_t capacity) {
+    char line[512];
+    size_t used = 0;
+
+    text[0] = '\0';
+
+    while (fgets(line, sizeof(line), stream) != NULL) {
+        if (strcmp(line, ".\n") == 0)
+            return RESPONSE_MORE;
+
+        if (strcmp(line, ".end\n") == 0)
+            return RESPONSE_LAST;
+
+        size_t length = strlen(line);
+
+        if (used + length < capacity) {
+            memcpy(text + used, line, length + 1);
+            used += length;
+        }
+    }
+
+    return RESPONSE_BROKEN;
+}
+
+static void closeSession(SoakSession* session) {
+    if (session->stream != NULL)
+        fclose(session->stream);
+
+    session->stream = NULL;
+    session->fd = -1;
+}
+
+static int openSession(SoakSession* session, const char* path) {
+    char greeting[1024];
+
+    session->fd = connectTo(path);
+    session->stream = session->fd < 0 ? NULL : fdopen(session->fd, "r");
+    session->step = STEP_BUILD;
+    session->roomsBuilt = 0;
+    session->turns = 0;
+    session->doomed = nextRandom(&session->random) % DOOMED_SHARE == 0;
+
+    if (session->stream == NULL) {
+        if (session->fd >= 0)
+            close(session->fd);
+
+        session->fd = -1;
+
+        return -1;
+    }
+
+    if (readResponse(session->stream, greeting, sizeof(greeting)) != RESPONSE_MORE
+         || strstr(greeting, "=== MENU ===") == NULL) {
+        closeSession(session);
+
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Build a row of rooms along x, some with a monster or an item, so every
+   world is connected and winnable unless the session is doomed, then its last
+   room holds the ogre. Then play random turns, with a bias to walk right and
+   fight, until the game ends or the turn budget runs out */
+static void nextRequest(SoakSession* session, char* request) {
+    unsigned int roll = nextRandom(&session->random);
+    int id = session->roomsBuilt;
+
+    switch (session->step) {
+    case STEP_BUILD:
+        if (id == 0)
+            sprintf(request, "1|0|1|Shield%u|0|%u\n", roll % 100, roll % 50);
+        else if (id == ROOMS_PER_WORLD - 1 && session->doomed)
+            sprintf(request, "1|%d|3|1|Ogre%d|3|2000000000|2000000000|0\n", id - 1, id);
+        else if (roll % 3 == 0)
+            sprintf(request, "1|%d|3|1|Rat%d|%u|1|1|0\n", id - 1, id, roll % 5);
+        else if (roll % 3 == 1)
+            sprintf(request, "1|%d|3|0|1|Blade%d|1|%u\n", id - 1, id, roll % 50);
+        else
+            sprintf(request, "1|%d|3|0|0\n", id - 1);
+        break;
+    case STEP_INIT:
+        strcpy(request, "2\n");
+        break;
+    case STEP_START:
+        strcpy(request, "3\n");
+        break;
+    default:
+        if (roll % 100 < 50)
+            sprintf(request, "1|%u\n", roll % 8 < 6 ? 3 : (roll / 8) % 4);
+        else if (roll % 100 < 75)
+            strcpy(request, "2\n");
+        else if (roll % 100 < 85)
+            strcpy(request, "3\n");
+        else if (roll % 100 < 92)
+            sprintf(request, "4|%u\n", 1 + (roll / 100) % 3);
+        else if (roll % 100 < 97)
+            sprintf(request, "5|%u\n", 1 + (roll / 100) % 3);
+        else
+            strcpy(request, "6\n");
+        break;
+    }
+}
+
+// Check the response against the request's step and move the session on. Return 0 if it looks right
+static int checkResponse(SoakSession* session, const char* response, ResponseEnd end) {
+    if (end == RESPONSE_BROKEN)
+        return -1;
+
+    switch (session->step) {
+    case STEP_BUILD:
+        if (strstr(response, "Created room") == NULL || end != RESPONSE_MORE)
+            return -1;
+
+        if (++session->roomsBuilt == ROOMS_PER_WORLD)
+            session->step = STEP_INIT;
+
+        return 0;
+    case STEP_INIT:
+        if (end != RESPONSE_MORE)
+            return -1;
+
+        session->step = STEP_START;
+
+        return 0;
+    case STEP_START:
+        // The world is checked on every Play, only the doomed ones may be warned about
+        if (strstr(response, "--- Room") == NULL || strstr(response, "World invalid") != NULL
+             || (strstr(response, UNWINNABLE_WARNING) != NULL) != session->doomed || end != RESPONSE_MORE)
+            return -1;
+
+        session->step = STEP_PLAY;
+
+        return 0;
+    default:
+        // Only a victory may end the session, or a death in a doomed world
+        if (end == RESPONSE_LAST)
+            return strstr(response, session->doomed ? "YOU DIED" : "VICTORY!") == NULL ? -1 : 0;
+
+        if (strstr(response, "=== MENU ===") != NULL)
+            session->step = STEP_START;
+
+        return 0;
+    }
+}
+
+static void* soakThreadMain(void* argument) {
+    SoakThread* soak = (SoakThread*)argument;
+    char request[MAX_REQUEST_LENGTH];
+    char response[4096];
+
+    for (int i = 0; i < soak->sessionCount; i++) {
+        soak->sessions[i].random = soak->seed * 7919u + (unsigned int)i * 104729u + 1;
+
+        if (openSession(&soak->sessions[i], soak->path) != 0)
+            soak->errors++;
+    }
+
+    // Every session is open and idle here, the main thread measures the server
+    pthread_barrier_wait(soak->connected);
+    pthread_barrier_wait(soak->connected);
+
+    while (nowSeconds() < soak->deadline) {
+        for (int i = 0; i < soak->sessionCount; i++) {
+            SoakSession* session = &soak->sessions[i];
+
+            if (session->stream == NULL && openSession(session, soak->path) != 0) {
+                soak->errors++;
+                continue;
+            }
+
+            nextRequest(session, request);
+
+            double before = nowSeconds();
+
+            if (send(session->fd, request, strlen(request), MSG_NOSIGNAL) < 0) {
+                soak->errors++;
+                closeSession(session);
+                continue;
+            }
+
+            ResponseEnd end = readResponse(session->stream, response, sizeof(response));
+
+            addSample(&soak->latency, nowSeconds() - before);
+            soak->requests++;
+
+            if (checkResponse(session, response, end) != 0) {
+                soak->errors++;
+                fprintf(stderr, "session %d: unexpected response to %s%s\n", i, request, response);
+                closeSession(session);
+                continue;
+            }
+
+            // A finished game starts over on a new connection, a long one is dropped mid-game
+            if (end == RESPONSE_LAST) {
+                if (session->doomed)
+                    soak->deaths++;
+                else
+                    soak->games++;
+
+                closeSession(session);
+            } else if (session->step == STEP_PLAY && ++session->turns == MAX_TURNS_PER_GAME) {
+                closeSession(session);
+            }
+        }
+    }
+
+    for (int i = 0; i < soak->sessionCount; i++) {
+        closeSession(&soak->sessions[i]);
+    }
+
+    return NULL;
+}
+
+// Resident set size of the process in kB, or -1 if it can't be read
+static long residentKilobytes(long pid) {
+    char path[64];
+    char line[256];
+    long kilobytes = -1;
+
+    snprintf(path, sizeof(path), "/proc/%ld/status", pid);
+
+    FILE* status = fopen(path, "r");
+
+    if (status == NULL)
+        return -1;
+
+    while (fgets(line, sizeof(line), status) != NULL) {
+        if (sscanf(line, "VmRSS: %ld", &kilobytes) == 1)
+            break;
+    }
+
+    fclose(status);
+
+    return kilobytes;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 6) {
+        fprintf(stderr, "Usage: %s <socket_path> [sessions] [seconds] [threads] [server_pid]\n", argv[0]);
+        return 1;
+    }
+
+    int sessionCount = argc > 2 ? atoi(argv[2]) : DEFAULT_SESSIONS;
+    int seconds = argc > 3 ? atoi(argv[3]) : DEFAULT_SECONDS;
+    int threadCount = argc > 4 ? atoi(argv[4]) : DEFAULT_THREADS;
+    long serverPid = argc > 5 ? atol(argv[5]) : 0;
+
+    if (sessionCount < 1 || seconds < 1 || threadCount < 1) {
+        fprintf(stderr, "sessions, seconds and threads must be positive\n");
+        return 1;
+    }
+
+    if (threadCount > sessionCount)
+        threadCount = sessionCount;
+
+    SoakSession* sessions = calloc(sessionCount, sizeof(SoakSession));
+    SoakThread* threads = calloc(threadCount, sizeof(SoakThread));
+    LatencySamples all = {NULL, 0, 0};
+    pthread_barrier_t connected;
+    long long requests = 0, games = 0, deaths = 0, errors = 0;
+
+    if (sessions == NULL || threads == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    pthread_barrier_init(&connected, NULL, threadCount + 1);
+
+    long baseKilobytes = serverPid > 0 ? residentKilobytes(serverPid) : -1;
+
+    for (int i = 0; i < threadCount; i++) {
+        int first = (int)((long long)sessionCount * i / threadCount);
+        int last = (int)((long long)sessionCount * (i + 1) / threadCount);
+
+        threads[i].path = argv[1];
+        threads[i].sessions = sessions + first;
+        threads[i].sessionCount = last - first;
+        threads[i].seed = (unsigned int)i + 1;
+        threads[i].connected = &connected;
+        pthread_create(&threads[i].thread, NULL, soakThreadMain, &threads[i]);
+    }
+
+    pthread_barrier_wait(&connected);
+
+    if (baseKilobytes >= 0) {
+        long idleKilobytes = residentKilobytes(serverPid);
+
+        fprintf(stderr, "server rss: %ld kB empty, %ld kB with %d idle sessions (%.1f kB per session)\n",
+             baseKilobytes, idleKilobytes, sessionCount, (double)(idleKilobytes - baseKilobytes) / sessionCount);
+    }
+
+    double start = nowSeconds();
+
+    for (int i = 0; i < threadCount; i++) {
+        threads[i].deadline = start + seconds;
+    }
+
+    pthread_barrier_wait(&connected);
+
+    for (int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i].thread, NULL);
+        requests += threads[i].requests;
+        games += threads[i].games;
+        deaths += threads[i].deaths;
+        errors += threads[i].errors;
+
+        for (int j = 0; j < threads[i].latency.count; j++) {
+            addSample(&all, threads[i].latency.samples[j]);
+        }
+
+        freeSamples(&threads[i].latency);
+    }
+
+    double elapsed = nowSeconds() - start;
+
+    sortSamples(&all);
+    fprintf(stderr, "sessions=%d threads=%d requests=%lld games_won=%lld games_lost=%lld errors=%lld"
+         " throughput=%.0f req/s\n", sessionCount, threadCount, requests, games, deaths, errors, requests / elapsed);
+    fprintf(stderr, "latency p50=%.1fus p99=%.1fus p999=%.1fus\n", percentile(&all, 0.5) * 1e6,
+         percentile(&all, 0.99) * 1e6, percentile(&all, 0.999) * 1e6);
+
+    if (serverPid > 0)
+        fprintf(stderr, "server rss at end: %ld kB\n", residentKilobytes(serverPid));
+
+    pthread_barrier_destroy(&connected);
+    freeSamples(&all);
+    free(threads);
+    free(sessions);
+
+    return errors == 0 ? 0 : 1;
+}
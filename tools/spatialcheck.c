@@ -0,0 +1,161 @@
+/* Tile map check: scatters rooms over a few clusters (one of them on a
+   corner of the coordinate range), then compares tileMapFind and tileMapQuery
+   against a brute-force scan of the inserted rooms for random points and
+   rectangles, including ones that reach past the valid range.
+   Build from the repository root:
+   gcc -std=c11 -O2 -I. tools/spatialcheck.c spatial.c -o spatialcheck
+   Usage: spatialcheck [rooms] [queries] [seed] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "spatial.h"
+
+#define DEFAULT_ROOMS 20000
+#define DEFAULT_QUERIES 2000
+#define CLUSTER_COUNT 3
+#define CLUSTER_SPREAD 300
+#define MAX_QUERY_SIDE 200
+#define MIN_COORDINATE (-SPATIAL_COORDINATE_OFFSET)
+#define MAX_COORDINATE (SPATIAL_COORDINATE_OFFSET - 1)
+
+typedef struct {
+    int x, y;
+    int id;
+} PlacedRoom;
+
+typedef struct {
+    const PlacedRoom* rooms;
+    int* seen;
+    int visits;
+    int bad;
+} QueryCheck;
+
+// The last cluster sits on a corner of the range, so half of it is out of bounds
+static const int CLUSTER_X[CLUSTER_COUNT] = {0, -5000, MAX_COORDINATE};
+static const int CLUSTER_Y[CLUSTER_COUNT] = {0, 7000, MIN_COORDINATE};
+
+static int inRange(int coordinate) {
+    return coordinate >= MIN_COORDINATE && coordinate <= MAX_COORDINATE;
+}
+
+static int randomNear(int center) {
+    return center + rand() % CLUSTER_SPREAD - CLUSTER_SPREAD / 2;
+}
+
+static void checkVisit(int x, int y, int roomId, void* context) {
+    QueryCheck* check = (QueryCheck*)context;
+    const PlacedRoom* room = &check->rooms[roomId];
+
+    // The id must belong to the reported cell and come up only once
+    if (room->x != x || room->y != y || check->seen[roomId]++ != 0)
+        check->bad++;
+
+    check->visits++;
+}
+
+// Return 1 if the query over the rectangle visits exactly the rooms a scan finds
+static int queryMatches(const TileMap* map, const PlacedRoom* rooms, int roomCount, int* seen,
+     int minX, int minY, int maxX, int maxY) {
+    QueryCheck check = {rooms, seen, 0, 0};
+    int expected = 0;
+
+    tileMapQuery(map, minX, minY, maxX, maxY, checkVisit, &check);
+
+    for (int i = 0; i < roomCount; i++) {
+        int inside = rooms[i].x >= minX && rooms[i].x <= maxX && rooms[i].y >= minY && rooms[i].y <= maxY;
+
+        if (inside != (seen[i] != 0))
+            check.bad++;
+
+        expected += inside;
+        seen[i] = 0;
+    }
+
+    return check.bad == 0 && check.visits == expected;
+}
+
+int main(int argc, char* argv[]) {
+    int roomTarget = argc > 1 ? atoi(argv[1]) : DEFAULT_ROOMS;
+    int queryCount = argc > 2 ? atoi(argv[2]) : DEFAULT_QUERIES;
+    unsigned int seed = argc > 3 ? (unsigned int)atoi(argv[3]) : 1;
+
+    if (roomTarget < 1 || queryCount < 1) {
+        fprintf(stderr, "Usage: %s [rooms] [queries] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    srand(seed);
+
+    TileMap map;
+    PlacedRoom* rooms = malloc(roomTarget * sizeof(PlacedRoom));
+    int* seen = calloc(roomTarget, sizeof(int));
+    int roomCount = 0;
+    int bad = 0;
+
+    if (rooms == NULL || seen == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    tileMapInit(&map);
+
+    // Some cells come up twice or lie out of range, the map must refuse those
+    for (int attempt = 0; attempt < roomTarget; attempt++) {
+        int cluster = rand() % CLUSTER_COUNT;
+        int x = randomNear(CLUSTER_X[cluster]);
+        int y = randomNear(CLUSTER_Y[cluster]);
+        int taken = tileMapFind(&map, x, y) != -1;
+        int outside = !inRange(x) || !inRange(y);
+        int inserted = tileMapInsert(&map, x, y, roomCount) == 0;
+
+        if (inserted == (taken || outside))
+            bad++;
+
+        if (inserted) {
+            rooms[roomCount] = (PlacedRoom){x, y, roomCount};
+            roomCount++;
+        }
+    }
+
+    for (int i = 0; i < roomCount; i++) {
+        if (tileMapFind(&map, rooms[i].x, rooms[i].y) != rooms[i].id)
+            bad++;
+    }
+
+    for (int q = 0; q < queryCount; q++) {
+        int cluster = rand() % CLUSTER_COUNT;
+        int minX = randomNear(CLUSTER_X[cluster]);
+        int minY = randomNear(CLUSTER_Y[cluster]);
+        int maxX = minX + rand() % MAX_QUERY_SIDE;
+        int maxY = minY + rand() % MAX_QUERY_SIDE;
+
+        if (!queryMatches(&map, rooms, roomCount, seen, minX, minY, maxX, maxY))
+            bad++;
+
+        // Empty cells of the rectangle must not report a room either
+        int x = minX + rand() % (maxX - minX + 1);
+        int y = minY + rand() % (maxY - minY + 1);
+        int expected = -1;
+
+        for (int i = 0; i < roomCount && expected == -1; i++) {
+            if (rooms[i].x == x && rooms[i].y == y)
+                expected = rooms[i].id;
+        }
+
+        if (tileMapFind(&map, x, y) != expected)
+            bad++;
+    }
+
+    // A rectangle covering the whole range must visit every room once
+    if (!queryMatches(&map, rooms, roomCount, seen, 2 * MIN_COORDINATE, 2 * MIN_COORDINATE,
+         2 * MAX_COORDINATE, 2 * MAX_COORDINATE))
+        bad++;
+
+    printf("rooms=%d tiles=%d queries=%d bad=%d\n", roomCount, map.count, queryCount, bad);
+
+    tileMapFree(&map);
+    free(rooms);
+    free(seen);
+
+    return bad == 0 ? 0 : 1;
+}
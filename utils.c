@@ -2,26 +2,68 @@
 #include <stdlib.h>
 #include <string.h>
 #include "utils.h"
+#include "journal.h"
+#include "output.h"
 
 #define CAPACITY_PER_ITERATION 10
 
+static _Thread_local InputSource* currentInput = NULL;
+
+// Make source the current input of this thread and return the previous one, NULL for stdin
+InputSource* setInputSource(InputSource* source) {
+    InputSource* previous = currentInput;
+
+    currentInput = source;
+
+    return previous;
+}
+
+// Next answer of the current source, NULL once it runs out like stdin at EOF
+static const char* nextToken() {
+    if (currentInput->next >= currentInput->count)
+        return NULL;
+
+    return currentInput->tokens[currentInput->next++];
+}
+
 int getInt(const char* prompt) {
     int num;
     int character;
 
-    printf("%s", prompt);
+    // Sessions with their own input are neither replayed nor journaled
+    if (currentInput != NULL) {
+        const char* token = nextToken();
+        char* end;
+
+        if (token == NULL)
+            return INVALID_INDEX;
+
+        long value = strtol(token, &end, 10);
+
+        return end == token ? INVALID_INDEX : (int)value;
+    }
+
+    if (journalReplayInt(&num))
+        return num;
+
+    outString(prompt);
+    outFlush();
     
     // if input of number isnt successful
     if (scanf("%d", &num) != 1) {
         // clear buffer
         while ((character = getchar()) != '\n' && character != EOF);
 
+        journalRecordInt(INVALID_INDEX);
+
         return INVALID_INDEX;
     }
 
     // clear buffer
      while ((character = getchar()) != '\n' && character != EOF);
 
+    journalRecordInt(num);
+
     return num;
 }
 
@@ -29,13 +71,32 @@ char *getString(const char* prompt) {
     int length = 0;
     int character;
     int capacity = CAPACITY_PER_ITERATION;
+    char *string;
+
+    if (currentInput != NULL) {
+        const char* token = nextToken();
+
+        if (token == NULL)
+            token = "";
 
-    char *string = (char *)malloc(capacity * sizeof(char));
+        string = malloc(strlen(token) + 1);
+
+        if (string != NULL)
+            strcpy(string, token);
+
+        return string;
+    }
+
+    if (journalReplayString(&string))
+        return string;
+
+    string = (char *)malloc(capacity * sizeof(char));
 
     if (string == NULL) 
         return NULL;
 
-    printf("%s", prompt);
+    outString(prompt);
+    outFlush();
 
     while ((character = getchar()) != '\n' && character != EOF) {
         if (length >= capacity - 1) { 
@@ -56,6 +117,44 @@ char *getString(const char* prompt) {
     string[length] = '\0';
     // Decrease to needed size at the end
     char *finalStr = realloc(string, (length + 1) * sizeof(char));
+
+    if (finalStr != NULL)
+        string = finalStr;
+
+    journalRecordString(string);
     
-    return (finalStr != NULL) ? finalStr : string;
-}
\ No newline at end of file
+    return string;
+}
+
+// Take ownership of a malloc'd string, keeping it inline when it fits
+void nameSet(Name* name, char* string) {
+    if (string == NULL) {
+        name->text[0] = '\0';
+
+        return;
+    }
+
+    size_t length = strlen(string);
+
+    if (length < NAME_INLINE_CAPACITY) {
+        memcpy(name->text, string, length + 1);
+        free(string);
+
+        return;
+    }
+
+    name->heap = string;
+    name->text[NAME_INLINE_CAPACITY - 1] = NAME_ON_HEAP;
+}
+
+const char* nameText(const Name* name) {
+    return name->text[NAME_INLINE_CAPACITY - 1] == NAME_ON_HEAP ? name->heap : name->text;
+}
+
+void nameFree(Name* name) {
+    if (name->text[NAME_INLINE_CAPACITY - 1] == NAME_ON_HEAP)
+        free(name->heap);
+
+    name->text[0] = '\0';
+    name->text[NAME_INLINE_CAPACITY - 1] = '\0';
+}
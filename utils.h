@@ -2,8 +2,29 @@
 #define UTILS_H
 
 #define INVALID_INDEX -1
+#define NAME_INLINE_CAPACITY 16
+#define NAME_ON_HEAP ((char)0xFF)
+
+// Names shorter than the inline capacity are stored in place, longer ones on the heap
+typedef union {
+    char text[NAME_INLINE_CAPACITY];
+    char* heap;
+} Name;
+
+// Answers taken one per prompt in place of stdin, without printing the prompts
+typedef struct {
+    char** tokens;
+    int count;
+    int next;
+} InputSource;
+
+InputSource* setInputSource(InputSource* source);
 
 int getInt(const char* prompt);
 char* getString(const char* prompt);
 
+void nameSet(Name* name, char* string);
+const char* nameText(const Name* name);
+void nameFree(Name* name);
+
 #endif
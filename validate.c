@@ -0,0 +1,311 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "validate.h"
+#include "combat.h"
+
+// Worlds smaller than this are checked on the calling thread
+#define PARALLEL_ROOM_THRESHOLD (1 << 16)
+#define MAX_VALIDATION_THREADS 8
+
+typedef struct {
+    GameState* gameState;
+    atomic_int* parent;
+    atomic_int* safeParent;
+    const MonsterBatch* monsters;
+    int roomBegin, roomEnd;
+    int monsterBegin, monsterEnd;
+    int playerHp;
+    int baseAttack;
+    int startRoot;
+    int safeRoot;
+    int unreachable;
+    long long healing;
+    int lostFights;
+    long long damage;
+    int failed;
+} ValidationTask;
+
+typedef void* (*TaskFunc)(void*);
+
+// Union-find over room ids. Roots always link to the smaller id, so concurrent unions can't form cycles
+static int findRoot(atomic_int* parent, int node) {
+    while (1) {
+        int next = atomic_load(&parent[node]);
+
+        if (next == node)
+            return node;
+
+        int grandparent = atomic_load(&parent[next]);
+
+        // Path halving, losing the race only skips a shortcut
+        atomic_compare_exchange_weak(&parent[node], &next, grandparent);
+        node = grandparent;
+    }
+}
+
+static void unite(atomic_int* parent, int first, int second) {
+    while (1) {
+        first = findRoot(parent, first);
+        second = findRoot(parent, second);
+
+        if (first == second)
+            return;
+
+        if (first < second) {
+            int swap = first;
+            first = second;
+            second = swap;
+        }
+
+        int expected = first;
+
+        if (atomic_compare_exchange_strong(&parent[first], &expected, second))
+            return;
+    }
+}
+
+// A room is safe when entering it can't cost hp: no monster, or one that doesn't hit
+static int isSafeRoom(GameState* gameState, Room* room) {
+    Monster* monster = roomMonster(gameState, room);
+
+    return monster == NULL || monster->hp <= 0 || monster->attack <= 0;
+}
+
+/* Hp a monster with negative attack gives back: it answers every strike
+   but the last one */
+static long long fightHealing(const Monster* monster, int baseAttack) {
+    if (monster->attack >= 0 || monster->hp <= 0 || baseAttack <= 0)
+        return 0;
+
+    long long rounds = (monster->hp + (long long)baseAttack - 1) / baseAttack;
+
+    return (rounds - 1) * -(long long)monster->attack;
+}
+
+/* First pass: join every room with its right and lower neighbours, and the
+   safe rooms with their safe neighbours */
+static void* linkRooms(void* argument) {
+    ValidationTask* task = (ValidationTask*)argument;
+    GameState* gameState = task->gameState;
+
+    for (int id = task->roomBegin; id < task->roomEnd; id++) {
+        Room* room = roomAt(gameState, id);
+        Room* right = findRoomByCoordinates(gameState, room->x + 1, room->y);
+        Room* below = findRoomByCoordinates(gameState, room->x, room->y + 1);
+        int safe = isSafeRoom(gameState, room);
+
+        if (right != NULL) {
+            unite(task->parent, id, right->id);
+
+            if (safe && isSafeRoom(gameState, right))
+                unite(task->safeParent, id, right->id);
+        }
+
+        if (below != NULL) {
+            unite(task->parent, id, below->id);
+
+            if (safe && isSafeRoom(gameState, below))
+                unite(task->safeParent, id, below->id);
+        }
+    }
+
+    return NULL;
+}
+
+/* Second pass: count the rooms outside the start room's component, and the
+   healing within reach before the first fight that hurts */
+static void* countRooms(void* argument) {
+    ValidationTask* task = (ValidationTask*)argument;
+
+    for (int id = task->roomBegin; id < task->roomEnd; id++) {
+        if (findRoot(task->parent, id) != task->startRoot)
+            task->unreachable++;
+
+        if (task->safeRoot >= 0 && findRoot(task->safeParent, id) == task->safeRoot) {
+            Monster* monster = roomMonster(task->gameState, roomAt(task->gameState, id));
+
+            if (monster != NULL)
+                task->healing += fightHealing(monster, task->baseAttack);
+        }
+    }
+
+    return NULL;
+}
+
+// Third pass: resolve this task's share of the monsters against the player
+static void* resolveFights(void* argument) {
+    ValidationTask* task = (ValidationTask*)argument;
+    int count = task->monsterEnd - task->monsterBegin;
+
+    if (count == 0)
+        return NULL;
+
+    MonsterBatch slice = {task->monsters->hp + task->monsterBegin, task->monsters->attack + task->monsterBegin,
+         count, count};
+    CombatOutcomes* outcomes = createCombatOutcomes(count);
+
+    if (outcomes == NULL) {
+        task->failed = 1;
+
+        return NULL;
+    }
+
+    // The resolver refuses a player who can't deal damage, no fight can be won then
+    if (resolveCombatBatch(&slice, task->baseAttack, task->playerHp, outcomes) != 0) {
+        task->lostFights += count;
+        destroyCombatOutcomes(outcomes);
+
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+        task->damage += outcomes->damageTaken[i];
+        task->lostFights += !outcomes->won[i];
+    }
+
+    destroyCombatOutcomes(outcomes);
+
+    return NULL;
+}
+
+static void runTasks(ValidationTask* tasks, int taskCount, TaskFunc func) {
+    pthread_t threads[MAX_VALIDATION_THREADS];
+    int started[MAX_VALIDATION_THREADS] = {0};
+
+    for (int i = 1; i < taskCount; i++) {
+        started[i] = pthread_create(&threads[i], NULL, func, &tasks[i]) == 0;
+
+        if (!started[i])
+            func(&tasks[i]);
+    }
+
+    func(&tasks[0]);
+
+    for (int i = 1; i < taskCount; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+    }
+}
+
+static int chooseTaskCount(int roomCount) {
+    if (roomCount < PARALLEL_ROOM_THRESHOLD)
+        return 1;
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (processors < 1)
+        return 1;
+
+    return processors > MAX_VALIDATION_THREADS ? MAX_VALIDATION_THREADS : (int)processors;
+}
+
+/* Check that every room can be reached from the start room and that a player
+   with playerHp and baseAttack can beat every monster left. The damage of a
+   fight doesn't depend on the hp left, so the fights can be won in any order
+   exactly when their total damage stays below the hp. Monsters with negative
+   attack heal instead, but only the ones reachable through safe rooms are
+   sure to be fought before the first damage, so only their healing is added
+   (capped at INT_MAX). Healing further in is ignored, which can make a
+   winnable world look unwinnable but never the other way round.
+   Return 0 for a valid world, -1 otherwise, with the details in report.
+   checkFailed is set when memory runs out, the other fields are incomplete then */
+int validateWorld(GameState* gameState, int playerHp, int baseAttack, WorldReport* report) {
+    int roomCount = gameState->roomCount;
+    Room* start = findRoomByCoordinates(gameState, 0, 0);
+    size_t parentSize = (roomCount > 0 ? roomCount : 1) * sizeof(atomic_int);
+    atomic_int* parent = malloc(parentSize);
+    atomic_int* safeParent = malloc(parentSize);
+    MonsterBatch* monsters = collectMonsters(gameState);
+    ValidationTask tasks[MAX_VALIDATION_THREADS];
+    int taskCount = chooseTaskCount(roomCount);
+
+    report->unreachableRooms = 0;
+    report->monsterCount = 0;
+    report->lostFights = 0;
+    report->totalDamage = 0;
+    report->winnable = 0;
+    report->checkFailed = 0;
+
+    if (parent == NULL || safeParent == NULL || monsters == NULL || start == NULL) {
+        if (start == NULL)
+            report->unreachableRooms = roomCount;
+        else
+            report->checkFailed = 1;
+
+        free(parent);
+        free(safeParent);
+        destroyMonsterBatch(monsters);
+
+        return -1;
+    }
+
+    for (int id = 0; id < roomCount; id++) {
+        atomic_init(&parent[id], id);
+        atomic_init(&safeParent[id], id);
+    }
+
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].gameState = gameState;
+        tasks[i].parent = parent;
+        tasks[i].safeParent = safeParent;
+        tasks[i].monsters = monsters;
+        tasks[i].playerHp = playerHp;
+        tasks[i].baseAttack = baseAttack;
+        tasks[i].roomBegin = (int)((long long)roomCount * i / taskCount);
+        tasks[i].roomEnd = (int)((long long)roomCount * (i + 1) / taskCount);
+        tasks[i].monsterBegin = (int)((long long)monsters->count * i / taskCount);
+        tasks[i].monsterEnd = (int)((long long)monsters->count * (i + 1) / taskCount);
+        tasks[i].unreachable = 0;
+        tasks[i].healing = 0;
+        tasks[i].lostFights = 0;
+        tasks[i].damage = 0;
+        tasks[i].failed = 0;
+    }
+
+    runTasks(tasks, taskCount, linkRooms);
+
+    int startRoot = findRoot(parent, start->id);
+    // A hurting monster in the start room is fought before anything else
+    int safeRoot = isSafeRoom(gameState, start) ? findRoot(safeParent, start->id) : -1;
+
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].startRoot = startRoot;
+        tasks[i].safeRoot = safeRoot;
+    }
+
+    runTasks(tasks, taskCount, countRooms);
+
+    long long healedHp = playerHp;
+
+    for (int i = 0; i < taskCount; i++) {
+        report->unreachableRooms += tasks[i].unreachable;
+        healedHp += tasks[i].healing;
+    }
+
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].playerHp = healedHp > INT_MAX ? INT_MAX : (int)healedHp;
+    }
+
+    runTasks(tasks, taskCount, resolveFights);
+
+    for (int i = 0; i < taskCount; i++) {
+        report->lostFights += tasks[i].lostFights;
+        report->totalDamage += tasks[i].damage;
+        report->checkFailed |= tasks[i].failed;
+    }
+
+    report->monsterCount = monsters->count;
+    report->winnable = !report->checkFailed && report->lostFights == 0
+         && (monsters->count == 0 || report->totalDamage < healedHp);
+
+    free(parent);
+    free(safeParent);
+    destroyMonsterBatch(monsters);
+
+    return !report->checkFailed && report->unreachableRooms == 0 && report->winnable ? 0 : -1;
+}
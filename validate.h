@@ -0,0 +1,17 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include "game.h"
+
+typedef struct {
+    int unreachableRooms;
+    int monsterCount;
+    int lostFights;
+    long long totalDamage;
+    int winnable;
+    int checkFailed;
+} WorldReport;
+
+int validateWorld(GameState* gameState, int playerHp, int baseAttack, WorldReport* report);
+
+#endif